@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "soa_vector.h"
+#include "tagged_tuple.h"
+
+namespace ftsd {
+
+// Like soa_vector, but rows are stored in tiles of TileSize rows, and each
+// tile stores its rows column by column. A scan that reads most columns of a
+// row then reads one tile at a time, instead of one stream per column, while
+// the values of a column are still contiguous within a tile for SIMD kernels.
+//
+// Every column type must be default constructible, as tiles are created full.
+// All tiles but the last have TileSize rows.
+template <typename TaggedTuple, std::size_t TileSize = 64>
+class aosoa_vector;
+
+template <auto... Tags, typename... Ts, auto... Inits, std::size_t TileSize>
+class aosoa_vector<tagged_tuple<member<Tags, Ts, Inits>...>, TileSize> {
+  using TaggedTuple = tagged_tuple<member<Tags, Ts, Inits>...>;
+  template <internal_tagged_tuple::fixed_string Tag>
+  using column_type = tagged_tuple_value_type_t<Tag, TaggedTuple>;
+
+  // Each column of a tile starts on a cache line.
+  template <typename T>
+  struct alignas(buffer_storage::alignment) tile_column_values {
+    std::array<T, TileSize> values;
+  };
+
+  struct tile {
+    tagged_tuple<member<Tags, tile_column_values<column_type<Tags>>>...>
+        columns;
+  };
+
+  std::vector<tile> tiles_;
+  std::size_t size_ = 0;
+
+ public:
+  using value_type = TaggedTuple;
+  using iterator = internal_soa_vector::row_iterator<aosoa_vector,
+                                                     TaggedTuple, false>;
+  using const_iterator =
+      internal_soa_vector::row_iterator<aosoa_vector, TaggedTuple, true>;
+
+  static constexpr std::size_t tile_size = TileSize;
+
+  aosoa_vector() = default;
+
+  void push_back(TaggedTuple t) {
+    if (size_ / TileSize == tiles_.size()) tiles_.emplace_back();
+    auto& columns = tiles_[size_ / TileSize].columns;
+    auto i = size_ % TileSize;
+    ((get<Tags>(columns).values[i] = std::move(get<Tags>(t))), ...);
+    ++size_;
+  }
+
+  // Constructs a TaggedTuple from args, such as tag<"id"> = 1.
+  template <typename... Args>
+  auto emplace_back(Args&&... args) {
+    push_back(TaggedTuple(std::forward<Args>(args)...));
+    return back();
+  }
+
+  // Resets the row to default values, so that it releases what it owns.
+  void pop_back() {
+    --size_;
+    auto& columns = tiles_[size_ / TileSize].columns;
+    auto i = size_ % TileSize;
+    ((get<Tags>(columns).values[i] = column_type<Tags>{}), ...);
+    if (size_ % TileSize == 0) tiles_.pop_back();
+  }
+
+  void clear() {
+    tiles_.clear();
+    size_ = 0;
+  }
+
+  void reserve(std::size_t n) { tiles_.reserve(tile_count(n)); }
+
+  std::size_t capacity() const { return tiles_.capacity() * TileSize; }
+
+  template <std::ranges::input_range R>
+  void append(R&& r) {
+    if constexpr (std::ranges::sized_range<R>) {
+      auto n = size() + std::ranges::size(r);
+      if (n > capacity()) reserve(std::max(n, 2 * capacity()));
+    }
+    for (auto&& t : r) push_back(std::forward<decltype(t)>(t));
+  }
+
+  std::size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  std::size_t tile_count() const { return tile_count(size_); }
+
+  // The values of column Tag in tile t.
+  template <internal_tagged_tuple::fixed_string Tag>
+  std::span<column_type<Tag>> tile_column(std::size_t t) {
+    auto& values = get<Tag>(tiles_[t].columns).values;
+    return std::span{values}.first(rows_in_tile(t));
+  }
+
+  template <internal_tagged_tuple::fixed_string Tag>
+  std::span<const column_type<Tag>> tile_column(std::size_t t) const {
+    auto& values = get<Tag>(tiles_[t].columns).values;
+    return std::span{values}.first(rows_in_tile(t));
+  }
+
+  // The values of column Tag, as a range over the columns of each tile.
+  template <internal_tagged_tuple::fixed_string Tag>
+  auto column() {
+    return tiles_ | std::views::transform([](tile& t) -> auto& {
+             return get<Tag>(t.columns).values;
+           }) |
+           std::views::join | std::views::take(size_);
+  }
+
+  template <internal_tagged_tuple::fixed_string Tag>
+  auto column() const {
+    return tiles_ | std::views::transform([](const tile& t) -> const auto& {
+             return get<Tag>(t.columns).values;
+           }) |
+           std::views::join | std::views::take(size_);
+  }
+
+  auto operator[](std::size_t i) {
+    auto& columns = tiles_[i / TileSize].columns;
+    auto j = i % TileSize;
+    return tagged_tuple_ref_t<TaggedTuple>(
+        (ftsd::tag<Tags> = std::ref(get<Tags>(columns).values[j]))...);
+  }
+
+  auto operator[](std::size_t i) const {
+    auto& columns = tiles_[i / TileSize].columns;
+    auto j = i % TileSize;
+    return tagged_tuple_ref_t<const TaggedTuple>(
+        (ftsd::tag<Tags> = std::cref(get<Tags>(columns).values[j]))...);
+  }
+
+  auto front() { return (*this)[0]; }
+  auto front() const { return (*this)[0]; }
+  auto back() { return (*this)[size() - 1]; }
+  auto back() const { return (*this)[size() - 1]; }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+ private:
+  static std::size_t tile_count(std::size_t rows) {
+    return (rows + TileSize - 1) / TileSize;
+  }
+
+  std::size_t rows_in_tile(std::size_t t) const {
+    return std::min(TileSize, size_ - t * TileSize);
+  }
+};
+
+template <typename Tag, typename TaggedTuple, std::size_t TileSize>
+auto get_impl(aosoa_vector<TaggedTuple, TileSize>& v) {
+  return v.template column<Tag::value>();
+}
+
+template <typename Tag, typename TaggedTuple, std::size_t TileSize>
+auto get_impl(const aosoa_vector<TaggedTuple, TileSize>& v) {
+  return v.template column<Tag::value>();
+}
+
+}  // namespace ftsd
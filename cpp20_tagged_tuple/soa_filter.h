@@ -0,0 +1,319 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "soa_vector.h"
+#include "tagged_tuple.h"
+
+namespace ftsd {
+
+namespace internal_soa_filter {
+
+// Rows are filtered in blocks of one bitmap word.
+inline constexpr std::size_t word_bits = 64;
+
+// Appends first + i for each bit i set in mask.
+inline void append_indices(std::vector<std::size_t>& indices,
+                           std::uint64_t mask, std::size_t first) {
+  for (; mask != 0; mask &= mask - 1) {
+    indices.push_back(first +
+                      static_cast<std::size_t>(std::countr_zero(mask)));
+  }
+}
+
+// The mask with bit i set if bytes[i] is 1, for bytes that are each 0 or 1.
+// Each multiplication gathers eight bytes into the top byte of a word.
+inline std::uint64_t pack_bits(const std::uint8_t (&bytes)[word_bits]) {
+  constexpr std::uint64_t gather = std::endian::native == std::endian::little
+                                       ? 0x0102040810204080
+                                       : 0x8040201008040201;
+  std::uint64_t mask = 0;
+  for (std::size_t i = 0; i < word_bits; i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    mask |= (word * gather) >> 56 << i;
+  }
+  return mask;
+}
+
+}  // namespace internal_soa_filter
+
+// One bit per row of a soa_vector, set for the rows selected by a predicate.
+class selection_bitmap {
+ public:
+  selection_bitmap() = default;
+  explicit selection_bitmap(std::size_t size)
+      : words_((size + word_bits - 1) / word_bits), size_(size) {}
+
+  std::size_t size() const { return size_; }
+
+  bool operator[](std::size_t i) const {
+    return (words_[i / word_bits] >> (i % word_bits)) & 1;
+  }
+
+  // The number of selected rows.
+  std::size_t count() const {
+    return std::accumulate(words_.begin(), words_.end(), std::size_t{0},
+                           [](std::size_t n, std::uint64_t word) {
+                             return n + std::popcount(word);
+                           });
+  }
+
+  // The indices of the selected rows, in increasing order.
+  std::vector<std::size_t> indices() const {
+    std::vector<std::size_t> indices;
+    for (std::size_t w = 0; w < words_.size(); ++w) {
+      internal_soa_filter::append_indices(indices, words_[w], w * word_bits);
+    }
+    return indices;
+  }
+
+  // Bit i of word w is row w * 64 + i. Bits past size() are 0.
+  std::span<std::uint64_t> words() { return words_; }
+  std::span<const std::uint64_t> words() const { return words_; }
+
+ private:
+  static constexpr std::size_t word_bits = internal_soa_filter::word_bits;
+
+  std::vector<std::uint64_t> words_;
+  std::size_t size_ = 0;
+};
+
+namespace internal_soa_filter {
+
+// A value compared with every row of a block.
+template <typename T>
+struct repeated_value {
+  const T& value;
+  const T& operator[](std::size_t) const { return value; }
+};
+
+// The rows of a column that returns values, such as a string column, from
+// row first on.
+template <typename Column>
+struct column_from {
+  Column column;
+  std::size_t first;
+  auto operator[](std::size_t i) const { return column[first + i]; }
+};
+
+// The rows of a block starting at row first, for a tag, or the value.
+template <typename TagOrValue, typename SoaVector>
+auto block_operand(const TagOrValue& tag_or_value, const SoaVector& v,
+                   std::size_t first) {
+  if constexpr (internal_tagged_tuple::is_tuple_tag_v<TagOrValue>) {
+    auto column = v.template column<TagOrValue::value>();
+    if constexpr (requires { column.data(); }) {
+      return column.data() + first;
+    } else {
+      return column_from<decltype(column)>{column, first};
+    }
+  } else {
+    return repeated_value<TagOrValue>{tag_or_value};
+  }
+}
+
+// Bit i is set if the predicate is true for row first + i, for i < n.
+template <typename Predicate, typename SoaVector>
+std::uint64_t row_mask(const Predicate& predicate, const SoaVector& v,
+                       std::size_t first, std::size_t n) {
+  std::uint64_t mask = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    mask |= static_cast<std::uint64_t>(predicate(v[first + i])) << i;
+  }
+  return mask;
+}
+
+// The mask of the 64 rows starting at first. Any predicate can be called on
+// the rows one at a time.
+template <typename Predicate, typename SoaVector>
+std::uint64_t block_mask(const Predicate& predicate, const SoaVector& v,
+                         std::size_t first) {
+  return row_mask(predicate, v, first, word_bits);
+}
+
+// A comparison from tag_relops is evaluated on a block of a column into one
+// byte per row, with a constant trip count and without branches, and the
+// bytes are then packed into the mask. GCC vectorizes the comparisons of
+// columns of up to 32 bits for baseline x86-64 (SSE2), and of 64 bit columns
+// with SSE4.2 (-march=x86-64-v2), which soa_vector_benchmark is built with.
+template <typename TagOrValue1, typename TagOrValue2,
+          internal_tagged_tuple::tag_comparison comparison, typename SoaVector>
+std::uint64_t block_mask(
+    const internal_tagged_tuple::tag_comparator_predicate<
+        TagOrValue1, TagOrValue2, comparison>& predicate,
+    const SoaVector& v, std::size_t first) {
+  auto a = block_operand(predicate.tag_or_value1, v, first);
+  auto b = block_operand(predicate.tag_or_value2, v, first);
+  std::uint8_t bytes[word_bits];
+  for (std::size_t i = 0; i < word_bits; ++i) {
+    bytes[i] = predicate.compare(a[i], b[i]);
+  }
+  return pack_bits(bytes);
+}
+
+// && and || combine the masks of the two predicates, and skip the second
+// predicate when the first one decides every row of the block.
+template <typename Predicate1, typename Predicate2,
+          internal_tagged_tuple::tag_logical logical, typename SoaVector>
+std::uint64_t block_mask(
+    const internal_tagged_tuple::tag_logical_predicate<Predicate1, Predicate2,
+                                                       logical>& predicate,
+    const SoaVector& v, std::size_t first) {
+  auto mask = block_mask(predicate.predicate1, v, first);
+  if constexpr (logical == internal_tagged_tuple::tag_logical::and_) {
+    if (mask == 0) return mask;
+    return mask & block_mask(predicate.predicate2, v, first);
+  } else {
+    if (mask == ~std::uint64_t{0}) return mask;
+    return mask | block_mask(predicate.predicate2, v, first);
+  }
+}
+
+// tag == value or tag != value, for a dictionary encoded column, which
+// compares the code of each row with the code of value. Rows are compared
+// with predicate.
+template <typename Predicate, typename Code>
+struct code_predicate {
+  Predicate predicate;
+  std::span<const Code> codes;
+  Code code;
+  bool equal;
+
+  template <typename Row>
+  bool operator()(const Row& row) const {
+    return predicate(row);
+  }
+};
+
+template <typename Predicate, typename Code, typename SoaVector>
+std::uint64_t block_mask(const code_predicate<Predicate, Code>& predicate,
+                         const SoaVector&, std::size_t first) {
+  auto codes = predicate.codes.data() + first;
+  std::uint8_t bytes[word_bits];
+  for (std::size_t i = 0; i < word_bits; ++i) {
+    bytes[i] = codes[i] == predicate.code;
+  }
+  auto mask = pack_bits(bytes);
+  return predicate.equal ? mask : ~mask;
+}
+
+// The predicate, with each comparison of a dictionary encoded column and a
+// value replaced by a code_predicate, which looks up the value once.
+template <typename Predicate, typename SoaVector>
+auto bind_codes(const Predicate& predicate, const SoaVector&) {
+  return predicate;
+}
+
+template <typename Predicate1, typename Predicate2,
+          internal_tagged_tuple::tag_logical logical, typename SoaVector>
+auto bind_codes(
+    const internal_tagged_tuple::tag_logical_predicate<Predicate1, Predicate2,
+                                                       logical>& predicate,
+    const SoaVector& v) {
+  auto predicate1 = bind_codes(predicate.predicate1, v);
+  auto predicate2 = bind_codes(predicate.predicate2, v);
+  return internal_tagged_tuple::tag_logical_predicate<
+      decltype(predicate1), decltype(predicate2), logical>{
+      std::move(predicate1), std::move(predicate2)};
+}
+
+template <typename TagOrValue1, typename TagOrValue2,
+          internal_tagged_tuple::tag_comparison comparison, typename SoaVector>
+auto bind_codes(const internal_tagged_tuple::tag_comparator_predicate<
+                    TagOrValue1, TagOrValue2, comparison>& predicate,
+                const SoaVector& v) {
+  using internal_tagged_tuple::is_tuple_tag_v;
+  using internal_tagged_tuple::tag_comparison;
+  constexpr bool tag_and_value =
+      is_tuple_tag_v<TagOrValue1> != is_tuple_tag_v<TagOrValue2>;
+  if constexpr (tag_and_value && (comparison == tag_comparison::eq ||
+                                  comparison == tag_comparison::ne)) {
+    const auto& [tag, value] = [&predicate] {
+      if constexpr (is_tuple_tag_v<TagOrValue1>) {
+        return std::tie(predicate.tag_or_value1, predicate.tag_or_value2);
+      } else {
+        return std::tie(predicate.tag_or_value2, predicate.tag_or_value1);
+      }
+    }();
+    using Tag = std::remove_cvref_t<decltype(tag)>;
+    auto column = v.template column<Tag::value>();
+    if constexpr (requires { column.base().code_of(value); }) {
+      const auto& dictionary = column.base();
+      return code_predicate<std::remove_cvref_t<decltype(predicate)>,
+                            typename std::remove_cvref_t<
+                                decltype(dictionary)>::code_type>{
+          predicate, dictionary.codes(), dictionary.code_of(value),
+          comparison == tag_comparison::eq};
+    } else {
+      return predicate;
+    }
+  } else {
+    return predicate;
+  }
+}
+
+// The mask of the rows starting at first. The last rows, if fewer than 64,
+// are evaluated one at a time.
+template <typename Predicate, typename SoaVector>
+std::uint64_t word_mask(const Predicate& predicate, const SoaVector& v,
+                        std::size_t first) {
+  auto n = v.size() - first;
+  if (n >= word_bits) return block_mask(predicate, v, first);
+  return row_mask(predicate, v, first, n);
+}
+
+}  // namespace internal_soa_filter
+
+// Selects the rows of v for which predicate is true. A predicate built with
+// tag_relops, such as tag<"score"> > 10.0 && tag<"id"> != 0, is evaluated one
+// column at a time. Any other predicate is called with each row.
+template <typename TaggedTuple, typename Storage, typename Predicate>
+selection_bitmap filter_bitmap(const soa_vector<TaggedTuple, Storage>& v,
+                               const Predicate& predicate) {
+  selection_bitmap selection(v.size());
+  auto words = selection.words();
+  auto bound = internal_soa_filter::bind_codes(predicate, v);
+  for (std::size_t w = 0; w < words.size(); ++w) {
+    words[w] = internal_soa_filter::word_mask(
+        bound, v, w * internal_soa_filter::word_bits);
+  }
+  return selection;
+}
+
+// The indices of the rows of v for which predicate is true, in increasing
+// order. Like filter_bitmap(v, predicate).indices(), without the bitmap.
+template <typename TaggedTuple, typename Storage, typename Predicate>
+std::vector<std::size_t> filter(const soa_vector<TaggedTuple, Storage>& v,
+                                const Predicate& predicate) {
+  std::vector<std::size_t> selection;
+  auto bound = internal_soa_filter::bind_codes(predicate, v);
+  for (std::size_t first = 0; first < v.size();
+       first += internal_soa_filter::word_bits) {
+    internal_soa_filter::append_indices(
+        selection, internal_soa_filter::word_mask(bound, v, first), first);
+  }
+  return selection;
+}
+
+// A copy of the rows of v for which predicate is true, gathered one column at
+// a time.
+template <typename TaggedTuple, typename Storage, typename Predicate>
+soa_vector<TaggedTuple, Storage> filter_copy(
+    const soa_vector<TaggedTuple, Storage>& v, const Predicate& predicate) {
+  auto selection = filter(v, predicate);
+  soa_vector<TaggedTuple, Storage> result;
+  result.append(selection |
+                std::views::transform([&v](std::size_t i) { return v[i]; }));
+  return result;
+}
+
+}  // namespace ftsd
@@ -0,0 +1,460 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "soa_parallel.h"
+#include "soa_vector.h"
+#include "tagged_tuple.h"
+
+namespace ftsd {
+
+namespace internal_soa_group_by {
+
+using internal_tagged_tuple::fixed_string;
+
+template <std::size_t N, std::size_t M>
+constexpr auto concat(const fixed_string<N>& a, const fixed_string<M>& b) {
+  char data[N + M + 1] = {};
+  std::copy_n(a.data, N, data);
+  std::copy_n(b.data, M, data + N);
+  return fixed_string<N + M>(data);
+}
+
+// An open addressing hash table, with linear probing, from keys to groups
+// numbered in the order their keys are first inserted. It grows when half
+// full.
+template <typename Key>
+class group_table {
+ public:
+  explicit group_table(std::size_t expected_groups) {
+    rehash(std::bit_ceil(std::max<std::size_t>(16, 2 * expected_groups)));
+  }
+
+  // The group of key, and whether it was just added.
+  std::pair<std::uint32_t, bool> insert(const Key& key) {
+    auto i = find_slot(key);
+    if (slots_[i].group != empty) return {slots_[i].group, false};
+    if (2 * (size_ + 1) > slots_.size()) {
+      rehash(2 * slots_.size());
+      i = find_slot(key);
+    }
+    slots_[i].key = key;
+    slots_[i].group = static_cast<std::uint32_t>(size_++);
+    return {slots_[i].group, true};
+  }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  static constexpr std::uint32_t empty = ~std::uint32_t{0};
+
+  struct slot {
+    Key key{};
+    std::uint32_t group = empty;
+  };
+
+  // The slot of key, or the empty slot where it would go.
+  std::size_t find_slot(const Key& key) const {
+    auto i = static_cast<std::size_t>(internal_soa_vector::mixed_hash(key) >>
+                                      shift_);
+    while (slots_[i].group != empty && !(slots_[i].key == key)) {
+      i = (i + 1) & (slots_.size() - 1);
+    }
+    return i;
+  }
+
+  void rehash(std::size_t capacity) {
+    auto old = std::exchange(slots_, std::vector<slot>(capacity));
+    shift_ = 64 - std::countr_zero(capacity);
+    for (auto& s : old) {
+      if (s.group != empty) slots_[find_slot(s.key)] = std::move(s);
+    }
+  }
+
+  std::vector<slot> slots_;
+  int shift_ = 0;
+  std::size_t size_ = 0;
+};
+
+// What the rows of column are grouped by: the codes of a dictionary encoded
+// column, so that each distinct string is hashed once, and otherwise the
+// values of the column.
+template <typename Column>
+auto group_keys(const Column& column) {
+  if constexpr (requires { column.base().codes(); }) {
+    return column.base().codes();
+  } else {
+    return column;
+  }
+}
+
+template <typename Column>
+using group_key_t =
+    std::remove_cvref_t<decltype(group_keys(std::declval<Column>())[0])>;
+
+template <fixed_string Key, typename TaggedTuple, typename... Aggregates>
+using result_tuple_t = tagged_tuple<
+    member<Key, tagged_tuple_value_type_t<Key, TaggedTuple>>,
+    member<Aggregates::name,
+           typename Aggregates::template result_type<TaggedTuple>>...>;
+
+// Rows are grouped and aggregated in blocks small enough for their groups to
+// stay in cache from one column to the next.
+inline constexpr std::size_t block_rows = 1024;
+
+// Groups the rows of v in rows, a random access range of row indices, and
+// aggregates them one column at a time.
+template <fixed_string Key, typename TaggedTuple, typename Storage,
+          typename Rows, typename... Aggregates>
+auto aggregate_rows(const soa_vector<TaggedTuple, Storage>& v,
+                    const Rows& rows, const Aggregates&... aggregates) {
+  auto keys = v.template column<Key>();
+  auto group_keys = internal_soa_group_by::group_keys(keys);
+  group_table<group_key_t<decltype(keys)>> table(
+      std::min<std::size_t>(std::ranges::size(rows), 4096));
+  std::vector<std::size_t> first_rows;
+  std::tuple<std::vector<
+      typename Aggregates::template state_type<TaggedTuple>>...>
+      states;
+
+  std::array<std::size_t, block_rows> row_block;
+  std::array<std::uint32_t, block_rows> group_block;
+  for (std::size_t first = 0; first < std::ranges::size(rows);
+       first += block_rows) {
+    auto n = std::min(block_rows, std::ranges::size(rows) - first);
+    for (std::size_t k = 0; k < n; ++k) {
+      auto i = rows[first + k];
+      auto [group, added] = table.insert(group_keys[i]);
+      if (added) {
+        first_rows.push_back(i);
+        std::apply(
+            [&](auto&... state) { (aggregates.add_group(v, i, state), ...); },
+            states);
+      }
+      row_block[k] = i;
+      group_block[k] = group;
+    }
+    std::apply(
+        [&](auto&... state) {
+          (aggregates.update(v, std::span(row_block).first(n),
+                             std::span(group_block).first(n), state),
+           ...);
+        },
+        states);
+  }
+
+  // Rows are added with push_back, as the columns of Storage, such as string
+  // columns, may not be writable in place.
+  soa_vector<result_tuple_t<Key, TaggedTuple, Aggregates...>, Storage> result;
+  result.reserve(first_rows.size());
+  for (std::size_t group = 0; group < first_rows.size(); ++group) {
+    std::apply(
+        [&](auto&... state) {
+          result.emplace_back(
+              tag<Key> = tagged_tuple_value_type_t<Key, TaggedTuple>(
+                  keys[first_rows[group]]),
+              tag<Aggregates::name> = Aggregates::finish(state[group])...);
+        },
+        states);
+  }
+  return result;
+}
+
+// The sum of a column, as a 64 bit integer for integral columns.
+template <typename T>
+using sum_type_t = std::conditional_t<
+    std::is_integral_v<T>,
+    std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>, T>;
+
+}  // namespace internal_soa_group_by
+
+// Aggregates for soa_grouping::aggregate. Each one adds a column to the
+// result: count adds "count", and sum<"score"> adds "sum_score".
+//
+// An aggregate keeps a state_type for each group. add_group appends the state
+// of a new group given its first row, update adds rows[k] to the state of
+// group groups[k], and finish turns a state into the result.
+namespace aggregates {
+
+struct count_t {
+  static constexpr internal_tagged_tuple::fixed_string name = "count";
+  template <typename TaggedTuple>
+  using state_type = std::size_t;
+  template <typename TaggedTuple>
+  using result_type = std::size_t;
+
+  template <typename SoaVector>
+  void add_group(const SoaVector&, std::size_t,
+                 std::vector<std::size_t>& states) const {
+    states.push_back(0);
+  }
+
+  template <typename SoaVector>
+  void update(const SoaVector&, std::span<const std::size_t>,
+              std::span<const std::uint32_t> groups,
+              std::vector<std::size_t>& states) const {
+    for (auto g : groups) ++states[g];
+  }
+
+  static std::size_t finish(std::size_t state) { return state; }
+};
+
+template <internal_tagged_tuple::fixed_string Tag>
+struct sum_t {
+  static constexpr auto name = internal_soa_group_by::concat(
+      internal_tagged_tuple::fixed_string("sum_"), Tag);
+  template <typename TaggedTuple>
+  using state_type = internal_soa_group_by::sum_type_t<
+      tagged_tuple_value_type_t<Tag, TaggedTuple>>;
+  template <typename TaggedTuple>
+  using result_type = state_type<TaggedTuple>;
+
+  template <typename SoaVector, typename State>
+  void add_group(const SoaVector&, std::size_t,
+                 std::vector<State>& states) const {
+    states.emplace_back();
+  }
+
+  template <typename SoaVector, typename State>
+  void update(const SoaVector& v, std::span<const std::size_t> rows,
+              std::span<const std::uint32_t> groups,
+              std::vector<State>& states) const {
+    auto column = v.template column<Tag>();
+    for (std::size_t k = 0; k < rows.size(); ++k) {
+      states[groups[k]] += column[rows[k]];
+    }
+  }
+
+  template <typename State>
+  static State finish(State& state) {
+    return std::move(state);
+  }
+};
+
+// The smallest value of the column in each group, compared with <.
+template <internal_tagged_tuple::fixed_string Tag>
+struct min_t {
+  static constexpr auto name = internal_soa_group_by::concat(
+      internal_tagged_tuple::fixed_string("min_"), Tag);
+  template <typename TaggedTuple>
+  using state_type = tagged_tuple_value_type_t<Tag, TaggedTuple>;
+  template <typename TaggedTuple>
+  using result_type = state_type<TaggedTuple>;
+
+  template <typename SoaVector, typename State>
+  void add_group(const SoaVector& v, std::size_t row,
+                 std::vector<State>& states) const {
+    states.emplace_back(v.template column<Tag>()[row]);
+  }
+
+  template <typename SoaVector, typename State>
+  void update(const SoaVector& v, std::span<const std::size_t> rows,
+              std::span<const std::uint32_t> groups,
+              std::vector<State>& states) const {
+    auto column = v.template column<Tag>();
+    for (std::size_t k = 0; k < rows.size(); ++k) {
+      const auto& value = column[rows[k]];
+      auto& state = states[groups[k]];
+      if (value < state) state = value;
+    }
+  }
+
+  template <typename State>
+  static State finish(State& state) {
+    return std::move(state);
+  }
+};
+
+// The largest value of the column in each group, compared with <.
+template <internal_tagged_tuple::fixed_string Tag>
+struct max_t {
+  static constexpr auto name = internal_soa_group_by::concat(
+      internal_tagged_tuple::fixed_string("max_"), Tag);
+  template <typename TaggedTuple>
+  using state_type = tagged_tuple_value_type_t<Tag, TaggedTuple>;
+  template <typename TaggedTuple>
+  using result_type = state_type<TaggedTuple>;
+
+  template <typename SoaVector, typename State>
+  void add_group(const SoaVector& v, std::size_t row,
+                 std::vector<State>& states) const {
+    states.emplace_back(v.template column<Tag>()[row]);
+  }
+
+  template <typename SoaVector, typename State>
+  void update(const SoaVector& v, std::span<const std::size_t> rows,
+              std::span<const std::uint32_t> groups,
+              std::vector<State>& states) const {
+    auto column = v.template column<Tag>();
+    for (std::size_t k = 0; k < rows.size(); ++k) {
+      const auto& value = column[rows[k]];
+      auto& state = states[groups[k]];
+      if (state < value) state = value;
+    }
+  }
+
+  template <typename State>
+  static State finish(State& state) {
+    return std::move(state);
+  }
+};
+
+template <internal_tagged_tuple::fixed_string Tag>
+struct mean_t {
+  static constexpr auto name = internal_soa_group_by::concat(
+      internal_tagged_tuple::fixed_string("mean_"), Tag);
+  struct state {
+    double sum = 0;
+    std::size_t count = 0;
+  };
+  template <typename TaggedTuple>
+  using state_type = state;
+  template <typename TaggedTuple>
+  using result_type = double;
+
+  template <typename SoaVector>
+  void add_group(const SoaVector&, std::size_t,
+                 std::vector<state>& states) const {
+    states.emplace_back();
+  }
+
+  template <typename SoaVector>
+  void update(const SoaVector& v, std::span<const std::size_t> rows,
+              std::span<const std::uint32_t> groups,
+              std::vector<state>& states) const {
+    auto column = v.template column<Tag>();
+    for (std::size_t k = 0; k < rows.size(); ++k) {
+      auto& s = states[groups[k]];
+      s.sum += static_cast<double>(column[rows[k]]);
+      ++s.count;
+    }
+  }
+
+  static double finish(const state& s) {
+    return s.sum / static_cast<double>(s.count);
+  }
+};
+
+inline constexpr count_t count{};
+
+template <internal_tagged_tuple::fixed_string Tag>
+inline constexpr sum_t<Tag> sum{};
+
+template <internal_tagged_tuple::fixed_string Tag>
+inline constexpr min_t<Tag> min{};
+
+template <internal_tagged_tuple::fixed_string Tag>
+inline constexpr max_t<Tag> max{};
+
+template <internal_tagged_tuple::fixed_string Tag>
+inline constexpr mean_t<Tag> mean{};
+
+}  // namespace aggregates
+
+// The rows of a soa_vector grouped by the values of column Key, as returned
+// by group_by. Key must be hashable with std::hash and comparable with ==.
+// The string columns of string_arena_storage are grouped by their
+// std::string_view, or by their codes if dictionary encoded.
+template <internal_tagged_tuple::fixed_string Key, typename TaggedTuple,
+          typename Storage>
+class soa_grouping {
+ public:
+  explicit soa_grouping(const soa_vector<TaggedTuple, Storage>& v) : v_(&v) {}
+
+  // Aggregates with threads threads. The rows are first partitioned by the
+  // hash of their key, so that each partition is aggregated on its own and
+  // no results need merging.
+  soa_grouping parallel(std::size_t threads) const {
+    auto grouping = *this;
+    grouping.threads_ = std::max<std::size_t>(threads, 1);
+    return grouping;
+  }
+
+  // A soa_vector with a row for each group, with the column Key followed by
+  // a column for each aggregate, such as
+  //
+  //   using namespace aggregates;
+  //   auto totals = group_by<"key">(v).aggregate(sum<"score">, count);
+  //   get<"sum_score">(totals[0]);
+  //
+  // Groups are in the order their keys first appear in v, unless parallel.
+  template <typename... Aggregates>
+  auto aggregate(const Aggregates&... aggregates) const {
+    if (threads_ == 1) {
+      return internal_soa_group_by::aggregate_rows<Key>(
+          *v_, std::views::iota(std::size_t{0}, v_->size()), aggregates...);
+    }
+    return aggregate_partitioned(aggregates...);
+  }
+
+ private:
+  template <typename... Aggregates>
+  auto aggregate_partitioned(const Aggregates&... aggregates) const {
+    using internal_soa_parallel::run_on_threads;
+    auto keys = internal_soa_group_by::group_keys(v_->template column<Key>());
+    // Partitions come from bits of the hash below those used by group_table.
+    auto partitions = std::bit_ceil(4 * threads_);
+    auto partition_of = [partitions](const auto& key) {
+      return static_cast<std::size_t>(
+          (internal_soa_vector::mixed_hash(key) >> 24) & (partitions - 1));
+    };
+
+    // Rows of partition p found by thread t are in buckets[t][p].
+    std::vector<std::vector<std::vector<std::size_t>>> buckets(
+        threads_, std::vector<std::vector<std::size_t>>(partitions));
+    run_on_threads(threads_, [&](std::size_t t) {
+      auto first = keys.size() * t / threads_;
+      auto last = keys.size() * (t + 1) / threads_;
+      for (auto i = first; i < last; ++i) {
+        buckets[t][partition_of(keys[i])].push_back(i);
+      }
+    });
+
+    using result_type = decltype(internal_soa_group_by::aggregate_rows<Key>(
+        *v_, std::span<const std::size_t>(), aggregates...));
+    std::vector<result_type> results(partitions);
+    std::atomic<std::size_t> next_partition{0};
+    run_on_threads(threads_, [&](std::size_t) {
+      for (std::size_t p; (p = next_partition++) < partitions;) {
+        std::vector<std::size_t> rows;
+        for (auto& thread_buckets : buckets) {
+          rows.insert(rows.end(), thread_buckets[p].begin(),
+                      thread_buckets[p].end());
+          std::vector<std::size_t>().swap(thread_buckets[p]);
+        }
+        results[p] = internal_soa_group_by::aggregate_rows<Key>(
+            *v_, std::span<const std::size_t>(rows), aggregates...);
+      }
+    });
+
+    result_type result;
+    std::size_t groups = 0;
+    for (auto& partial : results) groups += partial.size();
+    result.reserve(groups);
+    for (auto& partial : results) result.append(partial);
+    return result;
+  }
+
+  const soa_vector<TaggedTuple, Storage>* v_;
+  std::size_t threads_ = 1;
+};
+
+// Groups the rows of v by column Key, for aggregation.
+template <internal_tagged_tuple::fixed_string Key, typename TaggedTuple,
+          typename Storage>
+soa_grouping<Key, TaggedTuple, Storage> group_by(
+    const soa_vector<TaggedTuple, Storage>& v) {
+  return soa_grouping<Key, TaggedTuple, Storage>(v);
+}
+
+}  // namespace ftsd
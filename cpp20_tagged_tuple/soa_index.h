@@ -0,0 +1,436 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "soa_vector.h"
+#include "tagged_tuple.h"
+
+namespace ftsd {
+
+namespace internal_soa_index {
+
+using internal_tagged_tuple::fixed_string;
+
+// An open addressing hash table, with linear probing, from the values of
+// column Tag to the rows that hold them. Erasing shifts the following
+// entries back instead of leaving tombstones, so lookups never slow down
+// after many pop_backs.
+template <fixed_string Tag, typename Key>
+class hash_table {
+ public:
+  static constexpr auto tag = Tag;
+  static constexpr bool ordered = false;
+
+  hash_table() { rehash(16); }
+
+  template <typename SoaVector>
+  void insert_rows(const SoaVector& v, std::size_t first, std::size_t last) {
+    auto keys = v.template column<Tag>();
+    reserve(size_ + (last - first));
+    for (auto row = first; row < last; ++row) insert(keys[row], row);
+  }
+
+  // Erases the entries of the rows that are in the table.
+  template <typename SoaVector>
+  void erase_rows(const SoaVector& v, std::size_t first, std::size_t last) {
+    auto keys = v.template column<Tag>();
+    for (auto row = first; row < last; ++row) erase(keys[row], row);
+  }
+
+  void clear() {
+    std::ranges::fill(slots_, slot{});
+    size_ = 0;
+  }
+
+  // Calls f with each row whose value is key.
+  template <typename F>
+  void for_each_equal(const Key& key, F f) const {
+    for (auto i = home(key); slots_[i].row != empty;
+         i = (i + 1) & (slots_.size() - 1)) {
+      if (slots_[i].key == key) f(slots_[i].row);
+    }
+  }
+
+ private:
+  static constexpr std::size_t empty = ~std::size_t{0};
+
+  struct slot {
+    Key key{};
+    std::size_t row = empty;
+  };
+
+  std::size_t home(const Key& key) const {
+    return static_cast<std::size_t>(internal_soa_vector::mixed_hash(key) >>
+                                    shift_);
+  }
+
+  void reserve(std::size_t entries) {
+    if (2 * entries > slots_.size()) rehash(std::bit_ceil(2 * entries));
+  }
+
+  void insert(const Key& key, std::size_t row) {
+    reserve(size_ + 1);
+    auto i = home(key);
+    while (slots_[i].row != empty) i = (i + 1) & (slots_.size() - 1);
+    slots_[i] = slot{key, row};
+    ++size_;
+  }
+
+  void erase(const Key& key, std::size_t row) {
+    auto mask = slots_.size() - 1;
+    auto i = home(key);
+    while (slots_[i].row != row || !(slots_[i].key == key)) {
+      if (slots_[i].row == empty) return;
+      i = (i + 1) & mask;
+    }
+    // Moves back each following entry whose home is not between the hole
+    // and the entry, as it could no longer be found past the hole.
+    for (auto j = (i + 1) & mask; slots_[j].row != empty; j = (j + 1) & mask) {
+      auto h = home(slots_[j].key);
+      if (((j - h) & mask) >= ((j - i) & mask)) {
+        slots_[i] = std::move(slots_[j]);
+        i = j;
+      }
+    }
+    slots_[i] = slot{};
+    --size_;
+  }
+
+  void rehash(std::size_t capacity) {
+    auto old = std::exchange(slots_, std::vector<slot>(capacity));
+    shift_ = 64 - std::countr_zero(capacity);
+    for (auto& s : old) {
+      if (s.row == empty) continue;
+      auto i = home(s.key);
+      while (slots_[i].row != empty) i = (i + 1) & (capacity - 1);
+      slots_[i] = std::move(s);
+    }
+  }
+
+  std::vector<slot> slots_;
+  int shift_ = 0;
+  std::size_t size_ = 0;
+};
+
+// The values of column Tag and their rows, sorted by value and then row, in
+// leaves of at most 2 * leaf_size entries. Like the leaves of a B+ tree,
+// inserting or erasing moves at most one leaf, and a range is read leaf by
+// leaf. The first entry of each leaf is kept apart, in firsts_, so that
+// finding a leaf reads a single array.
+template <fixed_string Tag, typename Key>
+class ordered_table {
+ public:
+  static constexpr auto tag = Tag;
+  static constexpr bool ordered = true;
+
+  // Appending at least this fraction of the rows rebuilds the table. A
+  // rebuild copies the entries and replaces the table only once it is built,
+  // so that if a copy throws the table is left as it was.
+  static constexpr std::size_t rebuild_divisor = 4;
+
+  template <typename SoaVector>
+  void insert_rows(const SoaVector& v, std::size_t first, std::size_t last) {
+    auto keys = v.template column<Tag>();
+    if ((last - first) * rebuild_divisor < last) {
+      for (auto row = first; row < last; ++row) insert({keys[row], row});
+      return;
+    }
+    std::vector<entry> entries;
+    entries.reserve(last);
+    for (const auto& leaf : leaves_) {
+      entries.insert(entries.end(), leaf.begin(), leaf.end());
+    }
+    auto middle = entries.size();
+    for (auto row = first; row < last; ++row) {
+      entries.emplace_back(keys[row], row);
+    }
+    std::sort(entries.begin() + static_cast<std::ptrdiff_t>(middle),
+              entries.end());
+    std::ranges::inplace_merge(
+        entries, entries.begin() + static_cast<std::ptrdiff_t>(middle));
+    build(std::move(entries));
+  }
+
+  // Erases the entries of the rows that are in the table.
+  template <typename SoaVector>
+  void erase_rows(const SoaVector& v, std::size_t first, std::size_t last) {
+    auto keys = v.template column<Tag>();
+    for (auto row = first; row < last; ++row) erase({keys[row], row});
+  }
+
+  void clear() {
+    leaves_.clear();
+    firsts_.clear();
+  }
+
+  // Calls f with each row whose value is in [lo, hi), in order of value.
+  template <typename F>
+  void for_each_in_range(const Key& lo, const Key& hi, F f) const {
+    for_each_from(lo, [&hi](const Key& key) { return !(key < hi); }, f);
+  }
+
+  // Calls f with each row whose value is key, in order.
+  template <typename F>
+  void for_each_equal(const Key& key, F f) const {
+    for_each_from(key, [&key](const Key& k) { return key < k; }, f);
+  }
+
+ private:
+  static constexpr std::size_t leaf_size = 128;
+
+  using entry = std::pair<Key, std::size_t>;
+
+  // The leaf that holds e or would hold it.
+  std::size_t leaf_of(const entry& e) const {
+    auto it = std::ranges::upper_bound(firsts_, e);
+    return it == firsts_.begin()
+               ? 0
+               : static_cast<std::size_t>(it - firsts_.begin() - 1);
+  }
+
+  void insert(entry e) {
+    if (leaves_.empty()) {
+      leaves_.emplace_back();
+      firsts_.push_back(e);
+    }
+    auto l = leaf_of(e);
+    auto& leaf = leaves_[l];
+    leaf.insert(std::ranges::upper_bound(leaf, e), std::move(e));
+    firsts_[l] = leaf.front();
+    if (leaf.size() > 2 * leaf_size) {
+      std::vector<entry> upper(
+          std::make_move_iterator(leaf.begin() + leaf_size),
+          std::make_move_iterator(leaf.end()));
+      leaf.erase(leaf.begin() + leaf_size, leaf.end());
+      firsts_.insert(firsts_.begin() + static_cast<std::ptrdiff_t>(l + 1),
+                     upper.front());
+      leaves_.insert(leaves_.begin() + static_cast<std::ptrdiff_t>(l + 1),
+                     std::move(upper));
+    }
+  }
+
+  void erase(const entry& e) {
+    if (leaves_.empty()) return;
+    auto l = leaf_of(e);
+    auto& leaf = leaves_[l];
+    auto it = std::ranges::lower_bound(leaf, e);
+    if (it == leaf.end() || *it != e) return;
+    leaf.erase(it);
+    if (leaf.empty()) {
+      leaves_.erase(leaves_.begin() + static_cast<std::ptrdiff_t>(l));
+      firsts_.erase(firsts_.begin() + static_cast<std::ptrdiff_t>(l));
+    } else {
+      firsts_[l] = leaf.front();
+    }
+  }
+
+  // Calls f with the row of each entry from the first one whose value is not
+  // less than lo, until past(value).
+  template <typename Past, typename F>
+  void for_each_from(const Key& lo, Past past, F f) const {
+    if (leaves_.empty()) return;
+    for (auto l = leaf_of(entry{lo, 0}); l < leaves_.size(); ++l) {
+      const auto& leaf = leaves_[l];
+      for (auto it = std::ranges::lower_bound(leaf, lo, {}, &entry::first);
+           it != leaf.end(); ++it) {
+        if (past(it->first)) return;
+        f(it->second);
+      }
+    }
+  }
+
+  // Replaces the leaves with sorted entries.
+  void build(std::vector<entry> entries) {
+    std::vector<std::vector<entry>> leaves;
+    std::vector<entry> firsts;
+    for (std::size_t i = 0; i < entries.size(); i += leaf_size) {
+      auto last = std::min(i + leaf_size, entries.size());
+      leaves.emplace_back(
+          std::make_move_iterator(entries.begin() +
+                                  static_cast<std::ptrdiff_t>(i)),
+          std::make_move_iterator(entries.begin() +
+                                  static_cast<std::ptrdiff_t>(last)));
+      firsts.push_back(leaves.back().front());
+    }
+    leaves_.swap(leaves);
+    firsts_.swap(firsts);
+  }
+
+  std::vector<std::vector<entry>> leaves_;
+  std::vector<entry> firsts_;
+};
+
+}  // namespace internal_soa_index
+
+// An index for equality on column Tag, for indexed_soa_vector.
+template <internal_tagged_tuple::fixed_string Tag>
+struct hash_index {
+  template <typename TaggedTuple>
+  using table_type = internal_soa_index::hash_table<
+      Tag, tagged_tuple_value_type_t<Tag, TaggedTuple>>;
+};
+
+// An index for equality and ranges on column Tag, for indexed_soa_vector.
+template <internal_tagged_tuple::fixed_string Tag>
+struct ordered_index {
+  template <typename TaggedTuple>
+  using table_type = internal_soa_index::ordered_table<
+      Tag, tagged_tuple_value_type_t<Tag, TaggedTuple>>;
+};
+
+// A soa_vector, SoaVector, with indexes on some of its columns, such as
+//
+//   indexed_soa_vector<soa_vector<Person>, hash_index<"id">,
+//                      ordered_index<"score">> people;
+//   people.find<"id">(42);
+//   people.range<"score">(50.0, 60.0);
+//
+// Rows can only be changed through indexed_soa_vector, so that the indexes
+// stay consistent.
+template <typename SoaVector, typename... Indexes>
+class indexed_soa_vector {
+  using TaggedTuple = typename SoaVector::value_type;
+  template <internal_tagged_tuple::fixed_string Tag>
+  using column_type = tagged_tuple_value_type_t<Tag, TaggedTuple>;
+
+ public:
+  using value_type = TaggedTuple;
+  using const_iterator = typename SoaVector::const_iterator;
+
+  indexed_soa_vector() = default;
+
+  // The rows, for reading.
+  const SoaVector& rows() const { return rows_; }
+
+  template <internal_tagged_tuple::fixed_string Tag>
+  auto column() const {
+    return rows_.template column<Tag>();
+  }
+
+  // The rows whose column Tag equals value, from a hash_index on Tag, or an
+  // ordered_index if there is none.
+  template <internal_tagged_tuple::fixed_string Tag>
+  std::vector<std::size_t> find(const column_type<Tag>& value) const {
+    constexpr auto hash = index_of<Tag>(false);
+    constexpr auto i = hash < sizeof...(Indexes) ? hash : index_of<Tag>(true);
+    static_assert(i < sizeof...(Indexes), "no index on column Tag");
+    std::vector<std::size_t> found;
+    std::get<i>(tables_).for_each_equal(
+        value, [&found](std::size_t row) { found.push_back(row); });
+    return found;
+  }
+
+  // The rows whose column Tag is in [lo, hi), in order of Tag, from an
+  // ordered_index on Tag.
+  template <internal_tagged_tuple::fixed_string Tag>
+  std::vector<std::size_t> range(const column_type<Tag>& lo,
+                                 const column_type<Tag>& hi) const {
+    constexpr auto i = index_of<Tag>(true);
+    static_assert(i < sizeof...(Indexes), "no ordered_index on column Tag");
+    std::vector<std::size_t> found;
+    std::get<i>(tables_).for_each_in_range(
+        lo, hi, [&found](std::size_t row) { found.push_back(row); });
+    return found;
+  }
+
+  void push_back(TaggedTuple t) {
+    rows_.push_back(std::move(t));
+    index_rows(rows_.size() - 1);
+  }
+
+  // Constructs a TaggedTuple from args, such as tag<"id"> = 1.
+  template <typename... Args>
+  void emplace_back(Args&&... args) {
+    push_back(TaggedTuple(std::forward<Args>(args)...));
+  }
+
+  void pop_back() {
+    auto last = rows_.size() - 1;
+    std::apply(
+        [&](auto&... table) { (table.erase_rows(rows_, last, last + 1), ...); },
+        tables_);
+    rows_.pop_back();
+  }
+
+  // Appends the tagged_tuples in r. Indexes add many rows at once by
+  // rebuilding, which is faster than adding them one at a time.
+  template <std::ranges::input_range R>
+  void append(R&& r) {
+    auto first = rows_.size();
+    rows_.append(std::forward<R>(r));
+    index_rows(first);
+  }
+
+  void clear() {
+    rows_.clear();
+    std::apply([](auto&... table) { (table.clear(), ...); }, tables_);
+  }
+
+  void reserve(std::size_t n) { rows_.reserve(n); }
+
+  std::size_t size() const { return rows_.size(); }
+
+  bool empty() const { return rows_.empty(); }
+
+  auto operator[](std::size_t i) const { return rows_[i]; }
+  auto front() const { return rows_.front(); }
+  auto back() const { return rows_.back(); }
+
+  const_iterator begin() const { return rows_.begin(); }
+  const_iterator end() const { return rows_.end(); }
+
+ private:
+  // The position in Indexes of the first index on column Tag that is
+  // ordered, or not, or sizeof...(Indexes).
+  template <internal_tagged_tuple::fixed_string Tag>
+  static constexpr std::size_t index_of(bool ordered) {
+    std::array<std::string_view, sizeof...(Indexes)> tags{
+        table_type<Indexes>::tag.sv()...};
+    std::array<bool, sizeof...(Indexes)> ordereds{
+        table_type<Indexes>::ordered...};
+    for (std::size_t i = 0; i < tags.size(); ++i) {
+      if (tags[i] == Tag.sv() && ordereds[i] == ordered) return i;
+    }
+    return sizeof...(Indexes);
+  }
+
+  template <typename Index>
+  using table_type = typename Index::template table_type<TaggedTuple>;
+
+  // Adds rows from first on to every index. If that throws, removes them
+  // from the indexes that have them and from rows_.
+  void index_rows(std::size_t first) {
+    auto last = rows_.size();
+    try {
+      std::apply(
+          [&](auto&... table) { (table.insert_rows(rows_, first, last), ...); },
+          tables_);
+    } catch (...) {
+      std::apply(
+          [&](auto&... table) { (table.erase_rows(rows_, first, last), ...); },
+          tables_);
+      rows_.erase(rows_.begin() + static_cast<std::ptrdiff_t>(first),
+                  rows_.end());
+      throw;
+    }
+  }
+
+  SoaVector rows_;
+  std::tuple<table_type<Indexes>...> tables_;
+};
+
+template <typename Tag, typename SoaVector, typename... Indexes>
+auto get_impl(const indexed_soa_vector<SoaVector, Indexes...>& v) {
+  return v.template column<Tag::value>();
+}
+
+}  // namespace ftsd
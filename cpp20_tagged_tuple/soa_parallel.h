@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace ftsd {
+
+namespace internal_soa_parallel {
+
+// Calls f(t) for each t in [0, threads), on threads threads including the
+// calling thread, and rethrows the first exception thrown by f.
+template <typename F>
+void run_on_threads(std::size_t threads, F f) {
+  std::vector<std::exception_ptr> errors(threads);
+  auto run = [&](std::size_t t) {
+    try {
+      f(t);
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t t = 1; t < threads; ++t) workers.emplace_back(run, t);
+    run(0);
+  }
+  for (auto& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+}
+
+}  // namespace internal_soa_parallel
+
+}  // namespace ftsd
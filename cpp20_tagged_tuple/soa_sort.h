@@ -0,0 +1,243 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "soa_parallel.h"
+#include "soa_vector.h"
+#include "tagged_tuple.h"
+
+namespace ftsd {
+
+namespace internal_soa_sort {
+
+using internal_tagged_tuple::fixed_string;
+
+// Columns of these types are sorted with a radix sort.
+template <typename T>
+concept radix_sortable =
+    std::is_integral_v<T> ||
+    (std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+
+template <typename T>
+using radix_key_t = std::conditional_t<
+    sizeof(T) == 1, std::uint8_t,
+    std::conditional_t<
+        sizeof(T) == 2, std::uint16_t,
+        std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+
+// An unsigned integer that orders like value. Negative floating point
+// numbers have all their bits flipped, and other values their sign bit.
+// -0.0 has the key of 0.0, and every NaN, whatever its sign, has the largest
+// key, so NaNs are equal to each other and greater than every number.
+template <radix_sortable T>
+radix_key_t<T> radix_key(T value) {
+  using U = radix_key_t<T>;
+  constexpr auto sign = static_cast<U>(U{1} << (sizeof(U) * 8 - 1));
+  if constexpr (std::is_floating_point_v<T>) {
+    if (value != value) return std::numeric_limits<U>::max();
+    if (value == T{0}) value = T{0};
+    auto bits = std::bit_cast<U>(value);
+    return (bits & sign) ? static_cast<U>(~bits) : static_cast<U>(bits | sign);
+  } else if constexpr (std::is_signed_v<T>) {
+    return static_cast<U>(static_cast<U>(value) ^ sign);
+  } else {
+    return static_cast<U>(value);
+  }
+}
+
+// Sorts rows by keys with a least significant digit radix sort, one byte at
+// a time, skipping bytes that are the same for every key. Stable.
+template <typename U>
+void radix_sort(std::vector<U>& keys, std::span<std::size_t> rows) {
+  std::vector<U> sorted_keys(keys.size());
+  std::vector<std::size_t> sorted_rows(rows.begin(), rows.end());
+  std::vector<std::size_t> buffer_rows(rows.size());
+  for (std::size_t shift = 0; shift < sizeof(U) * 8; shift += 8) {
+    std::array<std::size_t, 256> offsets{};
+    for (auto key : keys) ++offsets[(key >> shift) & 0xff];
+    if (std::ranges::find(offsets, keys.size()) != offsets.end()) continue;
+    std::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(),
+                        std::size_t{0});
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      auto j = offsets[(keys[i] >> shift) & 0xff]++;
+      sorted_keys[j] = keys[i];
+      buffer_rows[j] = sorted_rows[i];
+    }
+    keys.swap(sorted_keys);
+    sorted_rows.swap(buffer_rows);
+  }
+  std::ranges::copy(sorted_rows, rows.begin());
+}
+
+// Stable sorts rows by the keys in columns Tags, the last key first.
+template <fixed_string Tag, fixed_string... Tags, typename SoaVector>
+void radix_sort_by(const SoaVector& v, std::span<std::size_t> rows) {
+  if constexpr (sizeof...(Tags) > 0) radix_sort_by<Tags...>(v, rows);
+  auto column = v.template column<Tag>();
+  std::vector<decltype(radix_key(column[0]))> keys(rows.size());
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    keys[i] = radix_key(column[rows[i]]);
+  }
+  radix_sort(keys, rows);
+}
+
+// What row_less compares: the radix_key of radix_sortable values, so that
+// comparison sorts and merges order them as radix_sort does, and otherwise
+// the value itself.
+template <typename T>
+decltype(auto) sort_key(const T& value) {
+  if constexpr (radix_sortable<T>) {
+    return radix_key(value);
+  } else {
+    return (value);
+  }
+}
+
+// Compares rows a and b of v by the sort_keys of columns Tags, in order,
+// with <.
+template <fixed_string... Tags, typename SoaVector>
+auto row_less(const SoaVector& v) {
+  return [columns = std::tuple(v.template column<Tags>()...)](std::size_t a,
+                                                             std::size_t b) {
+    return std::apply(
+        [a, b](const auto&... column) {
+          bool less = false;
+          ((sort_key(column[a]) < sort_key(column[b])
+                ? (less = true)
+                : sort_key(column[b]) < sort_key(column[a])) ||
+           ...);
+          return less;
+        },
+        columns);
+  };
+}
+
+// Sorts rows, indices into v, by columns Tags. Stable if stable, or if every
+// key is radix_sortable.
+template <fixed_string... Tags, typename TaggedTuple, typename Storage>
+void sort_rows(const soa_vector<TaggedTuple, Storage>& v,
+               std::span<std::size_t> rows, bool stable) {
+  if constexpr ((radix_sortable<tagged_tuple_value_type_t<Tags, TaggedTuple>> &&
+                 ...)) {
+    radix_sort_by<Tags...>(v, rows);
+  } else if (stable) {
+    std::ranges::stable_sort(rows, row_less<Tags...>(v));
+  } else {
+    std::ranges::sort(rows, row_less<Tags...>(v));
+  }
+}
+
+// Moves the values of column Tag so that row i holds what row permutation[i]
+// held.
+template <fixed_string Tag, typename SoaVector>
+void permute_column(SoaVector& v, std::span<const std::size_t> permutation) {
+  auto column = v.template column<Tag>();
+  std::vector<std::remove_cvref_t<decltype(column[0])>> permuted;
+  permuted.reserve(column.size());
+  for (auto i : permutation) permuted.push_back(std::move(column[i]));
+  std::ranges::move(permuted, column.begin());
+}
+
+template <typename TaggedTuple>
+struct column_permuter;
+
+template <auto... Tags, typename... Ts, auto... Inits>
+struct column_permuter<tagged_tuple<member<Tags, Ts, Inits>...>> {
+  // Permutes the columns c with c % threads == t, for each t on its own
+  // thread.
+  template <typename SoaVector>
+  static void permute(SoaVector& v, std::span<const std::size_t> permutation,
+                      std::size_t threads) {
+    internal_soa_parallel::run_on_threads(threads, [&](std::size_t t) {
+      std::size_t c = 0;
+      ((c++ % threads == t ? permute_column<Tags>(v, permutation) : void()),
+       ...);
+    });
+  }
+};
+
+}  // namespace internal_soa_sort
+
+// The rows of v in the order sort_by<Tags...> would put them: row i of the
+// sorted soa_vector is row permutation[i] of v.
+template <internal_tagged_tuple::fixed_string... Tags, typename TaggedTuple,
+          typename Storage>
+std::vector<std::size_t> sort_permutation(
+    const soa_vector<TaggedTuple, Storage>& v, bool stable = false) {
+  std::vector<std::size_t> permutation(v.size());
+  std::iota(permutation.begin(), permutation.end(), std::size_t{0});
+  internal_soa_sort::sort_rows<Tags...>(v, permutation, stable);
+  return permutation;
+}
+
+// Reorders v so that row i holds what row permutation[i] held, one column at
+// a time.
+template <typename TaggedTuple, typename Storage>
+void apply_permutation(soa_vector<TaggedTuple, Storage>& v,
+                       std::span<const std::size_t> permutation) {
+  internal_soa_sort::column_permuter<TaggedTuple>::permute(v, permutation, 1);
+}
+
+// Sorts the rows of v by column Tags[0], then Tags[1] and so on, with <.
+// The order is computed from the key columns alone, with a radix sort when
+// every key is an integer or floating point number, and a comparison sort
+// otherwise, and then applied to every column. -0.0 and 0.0 are equal keys,
+// and NaNs are equal to each other and come after every number.
+template <internal_tagged_tuple::fixed_string... Tags, typename TaggedTuple,
+          typename Storage>
+void sort_by(soa_vector<TaggedTuple, Storage>& v) {
+  apply_permutation(v, sort_permutation<Tags...>(v));
+}
+
+// Like sort_by, but rows with equal keys keep their order.
+template <internal_tagged_tuple::fixed_string... Tags, typename TaggedTuple,
+          typename Storage>
+void stable_sort_by(soa_vector<TaggedTuple, Storage>& v) {
+  apply_permutation(v, sort_permutation<Tags...>(v, true));
+}
+
+// Like stable_sort_by, with threads threads. Each thread sorts a slice of
+// the rows, slices are merged in pairs, and then each thread permutes some
+// of the columns.
+template <internal_tagged_tuple::fixed_string... Tags, typename TaggedTuple,
+          typename Storage>
+void parallel_sort_by(soa_vector<TaggedTuple, Storage>& v,
+                      std::size_t threads) {
+  using internal_soa_parallel::run_on_threads;
+  threads = std::max<std::size_t>(threads, 1);
+  std::vector<std::size_t> permutation(v.size());
+  std::iota(permutation.begin(), permutation.end(), std::size_t{0});
+  auto slice = [&](std::size_t s) {
+    return permutation.begin() +
+           static_cast<std::ptrdiff_t>(permutation.size() * s / threads);
+  };
+
+  run_on_threads(threads, [&](std::size_t t) {
+    internal_soa_sort::sort_rows<Tags...>(
+        std::as_const(v), std::span(slice(t), slice(t + 1)), true);
+  });
+  auto less = internal_soa_sort::row_less<Tags...>(std::as_const(v));
+  for (std::size_t width = 1; width < threads; width *= 2) {
+    std::atomic<std::size_t> next_merge{0};
+    run_on_threads(threads, [&](std::size_t) {
+      for (std::size_t s; (s = 2 * width * next_merge++) + width < threads;) {
+        std::inplace_merge(slice(s), slice(s + width),
+                           slice(std::min(s + 2 * width, threads)), less);
+      }
+    });
+  }
+  internal_soa_sort::column_permuter<TaggedTuple>::permute(v, permutation,
+                                                           threads);
+}
+
+}  // namespace ftsd
@@ -0,0 +1,479 @@
+#pragma once
+#include <boost/stl_interfaces/iterator_interface.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "soa_vector.h"
+#include "tagged_tuple.h"
+
+namespace ftsd {
+
+// Stores the std::string columns of a soa_vector as one arena of characters
+// per column, with the offset of each string, like Arrow's string layout, so
+// that rows don't allocate and scanning a column reads memory in order. The
+// columns named in DictionaryTags, such as string_arena_storage<"country">,
+// are dictionary encoded: each distinct string is stored once, and each row
+// holds the code of its string. Other columns are std::vectors. Tags in
+// DictionaryTags that are not columns are ignored, so that results with
+// fewer columns, like those of group_by, keep the storage.
+//
+// get<Tag> and operator[] return std::string_view for string columns, so
+// string values can be read, and rows added, inserted and erased, but string
+// values cannot be changed in place, as by sort_by.
+template <internal_tagged_tuple::fixed_string... DictionaryTags>
+struct string_arena_storage {};
+
+namespace internal_soa_vector {
+
+// The strings of a column, one after another in an arena: string i is
+// chars()[offsets()[i], offsets()[i + 1]). The first offset, 0, is added
+// with the first string, so that a column without strings, or moved from,
+// has no offsets.
+class string_column {
+ public:
+  using offset_type = std::uint32_t;
+
+  std::size_t size() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+  }
+
+  std::size_t capacity() const {
+    return offsets_.capacity() == 0 ? 0 : offsets_.capacity() - 1;
+  }
+
+  std::string_view operator[](std::size_t i) const {
+    return {chars_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]};
+  }
+
+  std::span<const offset_type> offsets() const { return offsets_; }
+  std::span<const char> chars() const { return chars_; }
+
+  void reserve(std::size_t n) { offsets_.reserve(n + 1); }
+
+  void push_back(std::string_view s) {
+    if (offsets_.empty()) offsets_.push_back(0);
+    offsets_.push_back(end_offset(s.size()));
+    try {
+      chars_.insert(chars_.end(), s.begin(), s.end());
+    } catch (...) {
+      offsets_.pop_back();
+      throw;
+    }
+  }
+
+  void pop_back() {
+    offsets_.pop_back();
+    chars_.resize(offsets_.back());
+  }
+
+  void clear() {
+    offsets_.clear();
+    chars_.clear();
+  }
+
+  void insert(std::size_t i, std::string_view s) {
+    push_back(s);
+    auto begin = offsets_[i];
+    std::rotate(chars_.begin() + begin, chars_.end() - s.size(),
+                chars_.end());
+    for (auto j = size(); j > i; --j) {
+      offsets_[j] = offsets_[j - 1] + static_cast<offset_type>(s.size());
+    }
+  }
+
+  void erase(std::size_t first, std::size_t last) {
+    if (first == last) return;
+    auto begin = offsets_[first];
+    auto end = offsets_[last];
+    chars_.erase(chars_.begin() + begin, chars_.begin() + end);
+    offsets_.erase(offsets_.begin() + static_cast<std::ptrdiff_t>(first) + 1,
+                   offsets_.begin() + static_cast<std::ptrdiff_t>(last) + 1);
+    for (auto j = first + 1; j < offsets_.size(); ++j) {
+      offsets_[j] -= end - begin;
+    }
+  }
+
+  // Appends the strings in values, reading each once. The arena grows
+  // geometrically, as it would with push_back, so that appending a few
+  // strings at a time stays amortized constant. If an exception is thrown,
+  // the column is left as it was.
+  template <typename Values>
+  void append(Values&& values) {
+    auto old_size = size();
+    try {
+      for (auto&& value : values) push_back(std::string_view(value));
+    } catch (...) {
+      erase(old_size, size());
+      throw;
+    }
+  }
+
+ private:
+  // The offset of the end of the arena after appending n characters.
+  offset_type end_offset(std::size_t n) const {
+    if (n > std::numeric_limits<offset_type>::max() - chars_.size()) {
+      throw std::length_error("string_column");
+    }
+    return static_cast<offset_type>(chars_.size() + n);
+  }
+
+  std::vector<offset_type> offsets_;
+  std::vector<char> chars_;
+};
+
+// Each distinct string of a column, stored once in dictionary(), and the
+// code of the string of each row, its index in dictionary(). Strings are
+// found by an open addressing hash table of codes, with linear probing.
+// Strings that no row has any more stay in the dictionary until clear.
+class dictionary_column {
+ public:
+  using code_type = std::uint32_t;
+
+  // The code of strings that are not in the dictionary.
+  static constexpr code_type no_code = ~code_type{0};
+
+  std::size_t size() const { return codes_.size(); }
+
+  std::size_t capacity() const { return codes_.capacity(); }
+
+  std::string_view operator[](std::size_t i) const {
+    return dictionary_[codes_[i]];
+  }
+
+  std::span<const code_type> codes() const { return codes_; }
+  const string_column& dictionary() const { return dictionary_; }
+
+  // The code of s, or no_code if no row has ever had it.
+  code_type code_of(std::string_view s) const {
+    if (slots_.empty()) return no_code;
+    for (auto i = home(s); slots_[i] != no_code;
+         i = (i + 1) & (slots_.size() - 1)) {
+      if (dictionary_[slots_[i]] == s) return slots_[i];
+    }
+    return no_code;
+  }
+
+  void reserve(std::size_t n) { codes_.reserve(n); }
+
+  void push_back(std::string_view s) {
+    auto code = intern(s);
+    codes_.push_back(code);
+  }
+
+  void pop_back() { codes_.pop_back(); }
+
+  void clear() {
+    codes_.clear();
+    dictionary_.clear();
+    std::ranges::fill(slots_, no_code);
+  }
+
+  void insert(std::size_t i, std::string_view s) {
+    auto code = intern(s);
+    codes_.insert(codes_.begin() + static_cast<std::ptrdiff_t>(i), code);
+  }
+
+  void erase(std::size_t first, std::size_t last) {
+    codes_.erase(codes_.begin() + static_cast<std::ptrdiff_t>(first),
+                 codes_.begin() + static_cast<std::ptrdiff_t>(last));
+  }
+
+  // Appends the strings in values. If an exception is thrown, the rows are
+  // left as they were.
+  template <typename Values>
+  void append(Values&& values) {
+    auto old_size = size();
+    try {
+      for (auto&& value : values) push_back(std::string_view(value));
+    } catch (...) {
+      erase(old_size, size());
+      throw;
+    }
+  }
+
+ private:
+  std::size_t home(std::string_view s) const {
+    return static_cast<std::size_t>(mixed_hash(s) >> shift_);
+  }
+
+  // The code of s, added to the dictionary if it is not there yet.
+  code_type intern(std::string_view s) {
+    if (2 * (dictionary_.size() + 1) > slots_.size()) {
+      rehash(std::max<std::size_t>(2 * slots_.size(), 16));
+    }
+    auto i = home(s);
+    for (; slots_[i] != no_code; i = (i + 1) & (slots_.size() - 1)) {
+      if (dictionary_[slots_[i]] == s) return slots_[i];
+    }
+    if (dictionary_.size() >= no_code) {
+      throw std::length_error("dictionary_column");
+    }
+    auto code = static_cast<code_type>(dictionary_.size());
+    dictionary_.push_back(s);
+    slots_[i] = code;
+    return code;
+  }
+
+  void rehash(std::size_t capacity) {
+    slots_.assign(capacity, no_code);
+    shift_ = 64 - std::countr_zero(capacity);
+    for (std::size_t code = 0; code < dictionary_.size(); ++code) {
+      auto i = home(dictionary_[code]);
+      while (slots_[i] != no_code) i = (i + 1) & (capacity - 1);
+      slots_[i] = static_cast<code_type>(code);
+    }
+  }
+
+  std::vector<code_type> codes_;
+  string_column dictionary_;
+  std::vector<code_type> slots_;
+  int shift_ = 0;
+};
+
+// A string_column or dictionary_column, for reading, like the std::span
+// that soa_vector returns for other columns. It refers to the column, and
+// is invalidated when rows are added or removed.
+template <typename Column>
+class string_column_view
+    : public std::ranges::view_interface<string_column_view<Column>> {
+ public:
+  class iterator
+      : public boost::stl_interfaces::proxy_iterator_interface<
+            iterator, std::random_access_iterator_tag, std::string_view> {
+    const Column* column_ = nullptr;
+    std::ptrdiff_t i_ = 0;
+
+    friend string_column_view;
+
+    iterator(const Column* column, std::size_t i)
+        : column_(column), i_(static_cast<std::ptrdiff_t>(i)) {}
+
+   public:
+    iterator() = default;
+
+    std::string_view operator*() const {
+      return (*column_)[static_cast<std::size_t>(i_)];
+    }
+
+    iterator& operator+=(std::ptrdiff_t n) {
+      i_ += n;
+      return *this;
+    }
+
+    std::ptrdiff_t operator-(iterator other) const { return i_ - other.i_; }
+  };
+
+  string_column_view() = default;
+  explicit string_column_view(const Column& column) : column_(&column) {}
+
+  iterator begin() const { return iterator(column_, 0); }
+  iterator end() const { return iterator(column_, size()); }
+
+  std::size_t size() const { return column_->size(); }
+
+  std::string_view operator[](std::size_t i) const { return (*column_)[i]; }
+
+  // The column, for its offsets and characters, or its codes and dictionary.
+  const Column& base() const { return *column_; }
+
+ private:
+  const Column* column_ = nullptr;
+};
+
+template <typename T, bool Dictionary>
+struct arena_column {
+  using type = std::vector<T>;
+};
+
+template <>
+struct arena_column<std::string, false> {
+  using type = string_column;
+};
+
+template <>
+struct arena_column<std::string, true> {
+  using type = dictionary_column;
+};
+
+template <internal_tagged_tuple::fixed_string... DictionaryTags, auto... Tags,
+          typename... Ts, auto... Inits>
+class column_storage<string_arena_storage<DictionaryTags...>,
+                     tagged_tuple<member<Tags, Ts, Inits>...>> {
+  using TaggedTuple = tagged_tuple<member<Tags, Ts, Inits>...>;
+
+  template <auto Tag>
+  static constexpr bool dictionary = ((Tag.sv() == DictionaryTags.sv()) || ...);
+
+  static_assert(((!dictionary<Tags> || std::is_same_v<Ts, std::string>) && ...),
+                "only std::string columns can be dictionary encoded");
+
+  tagged_tuple<member<
+      Tags, typename arena_column<tagged_tuple_value_type_t<Tags, TaggedTuple>,
+                                  dictionary<Tags>>::type>...>
+      columns_;
+
+  template <auto Tag, auto...>
+  const auto& first() const {
+    return get<Tag>(columns_);
+  }
+
+  template <typename T>
+  static void insert_row(std::vector<T>& column, std::size_t i, T&& value) {
+    column.insert(column.begin() + static_cast<std::ptrdiff_t>(i),
+                  std::move(value));
+  }
+
+  template <typename Column>
+  static void insert_row(Column& column, std::size_t i, std::string_view s) {
+    column.insert(i, s);
+  }
+
+  template <typename T>
+  static void erase_rows(std::vector<T>& column, std::size_t first,
+                         std::size_t last) {
+    column.erase(column.begin() + static_cast<std::ptrdiff_t>(first),
+                 column.begin() + static_cast<std::ptrdiff_t>(last));
+  }
+
+  template <typename Column>
+  static void erase_rows(Column& column, std::size_t first, std::size_t last) {
+    column.erase(first, last);
+  }
+
+  template <typename T, typename Values>
+  static void append_column(std::vector<T>& column, Values&& values) {
+    for (auto&& value : values) {
+      column.push_back(std::forward<decltype(value)>(value));
+    }
+  }
+
+  template <typename Column, typename Values>
+  static void append_column(Column& column, Values&& values) {
+    column.append(std::forward<Values>(values));
+  }
+
+  // Erases the rows from size on of the first count columns.
+  void truncate(std::size_t size, std::size_t count = sizeof...(Tags)) {
+    std::size_t i = 0;
+    ((i++ < count ? erase_rows(get<Tags>(columns_), size,
+                               get<Tags>(columns_).size())
+                  : void()),
+     ...);
+  }
+
+ public:
+  template <auto Tag>
+  auto column() {
+    return column_view(get<Tag>(columns_));
+  }
+
+  template <auto Tag>
+  auto column() const {
+    return column_view(get<Tag>(columns_));
+  }
+
+  std::size_t size() const { return first<Tags...>().size(); }
+
+  std::size_t capacity() const { return first<Tags...>().capacity(); }
+
+  void reserve(std::size_t n) { (get<Tags>(columns_).reserve(n), ...); }
+
+  template <typename Row>
+  void push_back(Row&& row) {
+    auto old_size = size();
+    std::size_t pushed = 0;
+    try {
+      ((get<Tags>(columns_).push_back(
+            column_value<Tags, TaggedTuple>(std::forward<Row>(row))),
+        ++pushed),
+       ...);
+    } catch (...) {
+      truncate(old_size, pushed);
+      throw;
+    }
+  }
+
+  void pop_back() { (get<Tags>(columns_).pop_back(), ...); }
+
+  void clear() { (get<Tags>(columns_).clear(), ...); }
+
+  void resize(std::size_t n, const TaggedTuple& value) {
+    auto old_size = size();
+    if (n <= old_size) {
+      truncate(n);
+      return;
+    }
+    append_columns(n - old_size, [&](auto tag) {
+      return std::views::iota(old_size, n) |
+             std::views::transform([&](std::size_t) -> const auto& {
+               return get<decltype(tag)::value>(value);
+             });
+    });
+  }
+
+  void insert(std::size_t i, TaggedTuple t) {
+    std::size_t inserted = 0;
+    try {
+      ((insert_row(get<Tags>(columns_), i, std::move(get<Tags>(t))),
+        ++inserted),
+       ...);
+    } catch (...) {
+      std::size_t c = 0;
+      ((c++ < inserted ? erase_rows(get<Tags>(columns_), i, i + 1) : void()),
+       ...);
+      throw;
+    }
+  }
+
+  void erase(std::size_t first, std::size_t last) {
+    (erase_rows(get<Tags>(columns_), first, last), ...);
+  }
+
+  // Appends n rows, one column at a time. values_for(tag<Tag>) returns a
+  // range of the n values of column Tag.
+  template <typename ValuesFor>
+  void append_columns(std::size_t n, ValuesFor values_for) {
+    auto old_size = size();
+    if (old_size + n > capacity()) {
+      reserve(std::max(old_size + n, 2 * capacity()));
+    }
+    try {
+      (append_column(get<Tags>(columns_), values_for(tag<Tags>)), ...);
+    } catch (...) {
+      truncate(old_size);
+      throw;
+    }
+  }
+
+ private:
+  template <typename T>
+  static auto column_view(std::vector<T>& column) {
+    return std::span{column};
+  }
+
+  template <typename T>
+  static auto column_view(const std::vector<T>& column) {
+    return std::span{column};
+  }
+
+  template <typename Column>
+  static auto column_view(const Column& column) {
+    return string_column_view<Column>(column);
+  }
+};
+
+}  // namespace internal_soa_vector
+
+}  // namespace ftsd
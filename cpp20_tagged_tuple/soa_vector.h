@@ -1,80 +1,667 @@
 #pragma once
 #include <boost/stl_interfaces/iterator_interface.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
 #include <span>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "tagged_tuple.h"
 
 namespace ftsd {
 
+// How a soa_vector stores its columns. With vector_storage each column is a
+// std::vector and grows on its own. With buffer_storage all columns share one
+// allocation and one capacity, each column starts on an alignment boundary,
+// and growing moves every column in one reallocation.
+struct vector_storage {};
+
+struct buffer_storage {
+  static constexpr std::size_t alignment = 64;
+};
+
+namespace internal_soa_vector {
+
+// The member Tag of t, moved from an rvalue TaggedTuple and copied from
+// anything else, including rvalue tagged_tuple_ref_t. It is returned by value
+// from an rvalue TaggedTuple, which may be a temporary made by a range, and
+// from an rvalue row that holds it by value, such as the std::string_view of
+// a string column.
+template <auto Tag, typename TaggedTuple, typename T>
+decltype(auto) column_value(T&& t) {
+  if constexpr (std::is_same_v<T, TaggedTuple>) {
+    return tagged_tuple_value_type_t<Tag, TaggedTuple>(get<Tag>(std::move(t)));
+  } else if constexpr (
+      !std::is_reference_v<T> &&
+      !std::is_reference_v<
+          tagged_tuple_value_type_t<Tag, std::remove_cvref_t<T>>>) {
+    return tagged_tuple_value_type_t<Tag, std::remove_cvref_t<T>>(
+        get<Tag>(t));
+  } else {
+    return get<Tag>(std::as_const(t));
+  }
+}
+
+// Spreads the bits of std::hash, which is the identity for integers on some
+// standard libraries, over the high bits, which hash tables over columns use
+// to pick a slot.
+template <typename Key>
+std::uint64_t mixed_hash(const Key& key) {
+  return static_cast<std::uint64_t>(std::hash<Key>{}(key)) *
+         0x9E3779B97F4A7C15;
+}
+
+// The member of a row for a value of a column: a reference to it, or the
+// value itself if the column returns values, as string columns return
+// std::string_view.
+template <typename T>
+auto row_member(T&& value) {
+  if constexpr (std::is_lvalue_reference_v<T>) {
+    return std::ref(value);
+  } else {
+    return value;
+  }
+}
+
+// Moves the values that a tagged_tuple_ref_t row refers to into a
+// TaggedTuple.
 template <typename TaggedTuple>
-class soa_vector;
+struct row_mover;
+
+template <auto... Tags, typename... Ts, auto... Inits>
+struct row_mover<tagged_tuple<member<Tags, Ts, Inits>...>> {
+  template <typename Ref>
+  static auto move(const Ref& row) {
+    return tagged_tuple<member<Tags, Ts, Inits>...>(
+        (tag<Tags> = std::move(get<Tags>(row)))...);
+  }
+};
+
+// A random access iterator over the rows of a Container, such as soa_vector,
+// whose reference is the row returned by Container::operator[], usually a
+// tagged_tuple_ref_t. Rows of references can be sorted with std::sort and
+// std::ranges::sort.
+template <typename Container, typename TaggedTuple, bool Const>
+class row_iterator
+    : public boost::stl_interfaces::proxy_iterator_interface<
+          row_iterator<Container, TaggedTuple, Const>,
+          std::random_access_iterator_tag, TaggedTuple,
+          decltype(std::declval<std::conditional_t<Const, const Container,
+                                                   Container>&>()[0])> {
+  using container_type = std::conditional_t<Const, const Container, Container>;
+  container_type* c_ = nullptr;
+  std::ptrdiff_t i_ = 0;
+
+  friend Container;
+  friend row_iterator<Container, TaggedTuple, !Const>;
+
+  row_iterator(container_type* c, std::size_t i)
+      : c_(c), i_(static_cast<std::ptrdiff_t>(i)) {}
+
+ public:
+  row_iterator() = default;
+  row_iterator(const row_iterator&) = default;
+  row_iterator& operator=(const row_iterator&) = default;
+  row_iterator(const row_iterator<Container, TaggedTuple, false>& other)
+      requires Const : c_(other.c_), i_(other.i_) {}
+
+  auto operator*() const { return (*c_)[static_cast<std::size_t>(i_)]; }
+
+  row_iterator& operator+=(std::ptrdiff_t n) {
+    i_ += n;
+    return *this;
+  }
+
+  std::ptrdiff_t operator-(row_iterator other) const { return i_ - other.i_; }
+
+  // Moves the row out, so that algorithms that hold a row in a temporary,
+  // like std::ranges::sort, move the values in the columns instead of
+  // copying them.
+  friend TaggedTuple iter_move(const row_iterator& it) requires(!Const) {
+    return row_mover<TaggedTuple>::move(*it);
+  }
+};
+
+template <typename Storage, typename TaggedTuple>
+class column_storage;
 
 template <auto... Tags, typename... Ts, auto... Inits>
-class soa_vector<tagged_tuple<member<Tags, Ts, Inits>...>> {
+class column_storage<vector_storage,
+                     tagged_tuple<member<Tags, Ts, Inits>...>> {
   using TaggedTuple = tagged_tuple<member<Tags, Ts, Inits>...>;
   tagged_tuple<member<
       Tags, std::vector<tagged_tuple_value_type_t<Tags, TaggedTuple>>>...>
       vectors_;
 
   template <auto Tag, auto...>
-  decltype(auto) first_helper() {
+  const auto& first() const {
     return get<Tag>(vectors_);
   }
 
-  template <auto Tag, auto...>
-  decltype(auto) first_helper() const {
-    return get<Tag>(vectors_);
+ public:
+  decltype(auto) vectors() { return (vectors_); }
+  decltype(auto) vectors() const { return (vectors_); }
+
+  template <auto Tag>
+  auto column() {
+    return std::span{get<Tag>(vectors_)};
   }
 
-  decltype(auto) first() { return first_helper<Tags...>(); }
+  template <auto Tag>
+  auto column() const {
+    return std::span{get<Tag>(vectors_)};
+  }
 
-  decltype(auto) first() const { return first_helper<Tags...>(); }
+  std::size_t size() const { return first<Tags...>().size(); }
 
- public:
-  soa_vector() = default;
-  decltype(auto) vectors() { return (vectors_); }
-  decltype(auto) vectors() const { return (vectors_); }
+  std::size_t capacity() const { return first<Tags...>().capacity(); }
 
-  void push_back(TaggedTuple t) {
-    (ftsd::get<Tags>(vectors_).push_back(get<Tags>(t)), ...);
+  void reserve(std::size_t n) { (get<Tags>(vectors_).reserve(n), ...); }
+
+  // Appends row, a TaggedTuple or a row with the same columns, such as a row
+  // of another soa_vector, moving from an rvalue TaggedTuple.
+  template <typename Row>
+  void push_back(Row&& row) {
+    auto old_size = size();
+    try {
+      (get<Tags>(vectors_).push_back(
+           column_value<Tags, TaggedTuple>(std::forward<Row>(row))),
+       ...);
+    } catch (...) {
+      truncate(old_size);
+      throw;
+    }
   }
 
   void pop_back() { (get<Tags>(vectors_).pop_back(), ...); }
 
   void clear() { (get<Tags>(vectors_).clear(), ...); }
 
-  std::size_t size() const { return first().size(); }
+  void resize(std::size_t n, const TaggedTuple& value) {
+    auto old_size = size();
+    try {
+      (get<Tags>(vectors_).resize(n, get<Tags>(value)), ...);
+    } catch (...) {
+      truncate(old_size);
+      throw;
+    }
+  }
+
+  void insert(std::size_t i, TaggedTuple t) {
+    std::size_t inserted = 0;
+    try {
+      ((get<Tags>(vectors_).insert(get<Tags>(vectors_).begin() + i,
+                                   std::move(get<Tags>(t))),
+        ++inserted),
+       ...);
+    } catch (...) {
+      std::size_t c = 0;
+      ((c++ < inserted ? void(get<Tags>(vectors_).erase(
+                             get<Tags>(vectors_).begin() + i))
+                       : void()),
+       ...);
+      throw;
+    }
+  }
+
+  // Erased rows cannot be put back, so if a column throws, as a throwing move
+  // assignment can, every column is cut to the size of the shortest one. The
+  // columns keep the same size, but the values of the rows are unspecified.
+  void erase(std::size_t first, std::size_t last) {
+    try {
+      (get<Tags>(vectors_).erase(get<Tags>(vectors_).begin() + first,
+                                 get<Tags>(vectors_).begin() + last),
+       ...);
+    } catch (...) {
+      truncate(std::min({get<Tags>(vectors_).size()...}));
+      throw;
+    }
+  }
+
+  // Appends n rows, one column at a time. values_for(tag<Tag>) returns a
+  // range of the n values of column Tag, and is called after the columns have
+  // grown.
+  template <typename ValuesFor>
+  void append_columns(std::size_t n, ValuesFor values_for) {
+    auto old_size = size();
+    if (old_size + n > capacity()) {
+      reserve(std::max(old_size + n, 2 * capacity()));
+    }
+    try {
+      (append_column(get<Tags>(vectors_), values_for(tag<Tags>)), ...);
+    } catch (...) {
+      truncate(old_size);
+      throw;
+    }
+  }
+
+ private:
+  // Erases the rows from size on. Each column is truncated on its own, as the
+  // columns may have grown by different numbers of rows.
+  void truncate(std::size_t size) {
+    (get<Tags>(vectors_).erase(get<Tags>(vectors_).begin() +
+                                   static_cast<std::ptrdiff_t>(size),
+                               get<Tags>(vectors_).end()),
+     ...);
+  }
+
+  template <typename Vector, typename Values>
+  static void append_column(Vector& column, Values&& values) {
+    for (auto&& value : values) {
+      column.push_back(std::forward<decltype(value)>(value));
+    }
+  }
+};
+
+template <auto... Tags, typename... Ts, auto... Inits>
+class column_storage<buffer_storage,
+                     tagged_tuple<member<Tags, Ts, Inits>...>> {
+  using TaggedTuple = tagged_tuple<member<Tags, Ts, Inits>...>;
+  using pointers = tagged_tuple<
+      member<Tags, tagged_tuple_value_type_t<Tags, TaggedTuple>*>...>;
+
+  static constexpr std::size_t alignment = std::max(
+      {buffer_storage::alignment,
+       alignof(tagged_tuple_value_type_t<Tags, TaggedTuple>)...});
+
+  std::byte* buffer_ = nullptr;
+  pointers columns_;
+  std::size_t size_ = 0;
+  std::size_t capacity_ = 0;
+
+  // The offset of each column in a buffer for capacity rows, followed by the
+  // size of the buffer.
+  static auto layout(std::size_t capacity) {
+    std::array<std::size_t, sizeof...(Tags) + 1> offsets{};
+    std::size_t i = 0;
+    std::size_t offset = 0;
+    ((offsets[i++] = offset,
+      offset += capacity * sizeof(tagged_tuple_value_type_t<Tags, TaggedTuple>),
+      offset = (offset + alignment - 1) / alignment * alignment),
+     ...);
+    offsets[i] = offset;
+    return offsets;
+  }
+
+  static std::byte* allocate(std::size_t capacity, pointers& columns) {
+    auto offsets = layout(capacity);
+    auto buffer = static_cast<std::byte*>(
+        ::operator new(offsets.back(), std::align_val_t{alignment}));
+    std::size_t i = 0;
+    ((get<Tags>(columns) =
+          reinterpret_cast<tagged_tuple_value_type_t<Tags, TaggedTuple>*>(
+              buffer + offsets[i++])),
+     ...);
+    return buffer;
+  }
+
+  static void deallocate(std::byte* buffer) {
+    ::operator delete(buffer, std::align_val_t{alignment});
+  }
+
+  // Destroys rows [first, last) of the first count columns.
+  static void destroy_rows(pointers& columns, std::size_t first,
+                           std::size_t last,
+                           std::size_t count = sizeof...(Tags)) {
+    std::size_t i = 0;
+    ((i++ < count ? std::destroy(get<Tags>(columns) + first,
+                                 get<Tags>(columns) + last)
+                  : void()),
+     ...);
+  }
+
+  template <typename T>
+  static void relocate(T* from, std::size_t n, T* to) {
+    if constexpr (std::is_nothrow_move_constructible_v<T> ||
+                  !std::is_copy_constructible_v<T>) {
+      std::uninitialized_move_n(from, n, to);
+    } else {
+      std::uninitialized_copy_n(from, n, to);
+    }
+  }
+
+  template <typename T, typename Values>
+  static void append_column(T* first, Values&& values) {
+    auto last = first;
+    try {
+      for (auto&& value : values) {
+        std::construct_at(last, std::forward<decltype(value)>(value));
+        ++last;
+      }
+    } catch (...) {
+      std::destroy(first, last);
+      throw;
+    }
+  }
+
+  void grow_for(std::size_t n) {
+    if (size_ + n > capacity_) {
+      reserve(std::max({size_ + n, 2 * capacity_, std::size_t{16}}));
+    }
+  }
+
+ public:
+  column_storage() = default;
+
+  // Delegates to the default constructor, so that the destructor frees the
+  // buffer if a copy throws.
+  column_storage(const column_storage& other) : column_storage() {
+    append_columns(other.size_, [&](auto tag) {
+      return other.template column<decltype(tag)::value>();
+    });
+  }
+
+  column_storage(column_storage&& other) noexcept
+      : buffer_(std::exchange(other.buffer_, nullptr)),
+        columns_(std::exchange(other.columns_, pointers{})),
+        size_(std::exchange(other.size_, 0)),
+        capacity_(std::exchange(other.capacity_, 0)) {}
+
+  column_storage& operator=(const column_storage& other) {
+    if (this != &other) *this = column_storage(other);
+    return *this;
+  }
+
+  column_storage& operator=(column_storage&& other) noexcept {
+    if (this != &other) {
+      clear();
+      deallocate(buffer_);
+      buffer_ = std::exchange(other.buffer_, nullptr);
+      columns_ = std::exchange(other.columns_, pointers{});
+      size_ = std::exchange(other.size_, 0);
+      capacity_ = std::exchange(other.capacity_, 0);
+    }
+    return *this;
+  }
+
+  ~column_storage() {
+    clear();
+    deallocate(buffer_);
+  }
+
+  template <auto Tag>
+  auto column() {
+    return std::span{get<Tag>(columns_), size_};
+  }
+
+  template <auto Tag>
+  auto column() const {
+    return std::span{
+        static_cast<const tagged_tuple_value_type_t<Tag, TaggedTuple>*>(
+            get<Tag>(columns_)),
+        size_};
+  }
+
+  std::size_t size() const { return size_; }
+
+  std::size_t capacity() const { return capacity_; }
+
+  void reserve(std::size_t n) {
+    if (n <= capacity_) return;
+    pointers columns;
+    auto buffer = allocate(n, columns);
+    std::size_t relocated = 0;
+    try {
+      ((relocate(get<Tags>(columns_), size_, get<Tags>(columns)),
+        ++relocated),
+       ...);
+    } catch (...) {
+      destroy_rows(columns, 0, size_, relocated);
+      deallocate(buffer);
+      throw;
+    }
+    destroy_rows(columns_, 0, size_);
+    deallocate(buffer_);
+    buffer_ = buffer;
+    columns_ = columns;
+    capacity_ = n;
+  }
+
+  template <typename Row>
+  void push_back(Row&& row) {
+    grow_for(1);
+    std::size_t constructed = 0;
+    try {
+      ((std::construct_at(
+            get<Tags>(columns_) + size_,
+            column_value<Tags, TaggedTuple>(std::forward<Row>(row))),
+        ++constructed),
+       ...);
+    } catch (...) {
+      destroy_rows(columns_, size_, size_ + 1, constructed);
+      throw;
+    }
+    ++size_;
+  }
+
+  void pop_back() {
+    destroy_rows(columns_, size_ - 1, size_);
+    --size_;
+  }
+
+  void clear() {
+    destroy_rows(columns_, 0, size_);
+    size_ = 0;
+  }
+
+  void resize(std::size_t n, const TaggedTuple& value) {
+    if (n <= size_) {
+      destroy_rows(columns_, n, size_);
+      size_ = n;
+      return;
+    }
+    append_columns(n - size_, [&](auto tag) {
+      return std::views::iota(size_, n) |
+             std::views::transform([&](std::size_t) -> const auto& {
+               return get<decltype(tag)::value>(value);
+             });
+    });
+  }
+
+  void insert(std::size_t i, TaggedTuple t) {
+    push_back(std::move(t));
+    (std::rotate(get<Tags>(columns_) + i, get<Tags>(columns_) + size_ - 1,
+                 get<Tags>(columns_) + size_),
+     ...);
+  }
+
+  void erase(std::size_t first, std::size_t last) {
+    (std::move(get<Tags>(columns_) + last, get<Tags>(columns_) + size_,
+               get<Tags>(columns_) + first),
+     ...);
+    destroy_rows(columns_, size_ - (last - first), size_);
+    size_ -= last - first;
+  }
+
+  // Appends n rows, one column at a time. values_for(tag<Tag>) returns a
+  // range of the n values of column Tag, and is called after the columns have
+  // grown.
+  template <typename ValuesFor>
+  void append_columns(std::size_t n, ValuesFor values_for) {
+    grow_for(n);
+    std::size_t appended = 0;
+    try {
+      ((append_column(get<Tags>(columns_) + size_, values_for(tag<Tags>)),
+        ++appended),
+       ...);
+    } catch (...) {
+      destroy_rows(columns_, size_, size_ + n, appended);
+      throw;
+    }
+    size_ += n;
+  }
+};
+
+}  // namespace internal_soa_vector
 
-  bool empty() const { return first().empty(); }
+template <typename TaggedTuple, typename Storage = vector_storage>
+class soa_vector;
+
+template <auto... Tags, typename... Ts, auto... Inits, typename Storage>
+class soa_vector<tagged_tuple<member<Tags, Ts, Inits>...>, Storage> {
+  using TaggedTuple = tagged_tuple<member<Tags, Ts, Inits>...>;
+  internal_soa_vector::column_storage<Storage, TaggedTuple> columns_;
+
+ public:
+  using value_type = TaggedTuple;
+  using iterator = internal_soa_vector::row_iterator<soa_vector, TaggedTuple,
+                                                     false>;
+  using const_iterator =
+      internal_soa_vector::row_iterator<soa_vector, TaggedTuple, true>;
+
+  soa_vector() = default;
+  decltype(auto) vectors() requires std::same_as<Storage, vector_storage> {
+    return columns_.vectors();
+  }
+  decltype(auto) vectors() const
+      requires std::same_as<Storage, vector_storage> {
+    return columns_.vectors();
+  }
+
+  // The values of column Tag, like get<Tag>.
+  template <internal_tagged_tuple::fixed_string Tag>
+  auto column() {
+    return columns_.template column<Tag>();
+  }
+
+  template <internal_tagged_tuple::fixed_string Tag>
+  auto column() const {
+    return columns_.template column<Tag>();
+  }
+
+  void push_back(TaggedTuple t) { columns_.push_back(std::move(t)); }
+
+  // Constructs a TaggedTuple from args, such as tag<"id"> = 1.
+  template <typename... Args>
+  auto emplace_back(Args&&... args) {
+    push_back(TaggedTuple(std::forward<Args>(args)...));
+    return back();
+  }
+
+  void pop_back() { columns_.pop_back(); }
+
+  void clear() { columns_.clear(); }
 
+  void reserve(std::size_t n) { columns_.reserve(n); }
+
+  std::size_t capacity() const { return columns_.capacity(); }
+
+  void resize(std::size_t n) { resize(n, TaggedTuple{}); }
+
+  void resize(std::size_t n, const TaggedTuple& value) {
+    columns_.resize(n, value);
+  }
+
+  iterator insert(const_iterator pos, TaggedTuple t) {
+    auto i = static_cast<std::size_t>(pos - cbegin());
+    columns_.insert(i, std::move(t));
+    return begin() + i;
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    auto i = static_cast<std::size_t>(first - cbegin());
+    columns_.erase(i, static_cast<std::size_t>(last - cbegin()));
+    return begin() + i;
+  }
+
+  // Appends the rows in r, tagged_tuples or rows of another soa_vector. Each
+  // row is read once, and the space for a forward range is reserved first. If
+  // an exception is thrown, the soa_vector is left as it was.
+  template <std::ranges::input_range R>
+  void append(R&& r) {
+    auto old_size = size();
+    if constexpr (std::ranges::forward_range<R>) {
+      auto n = static_cast<std::size_t>(std::ranges::distance(r));
+      if (old_size + n > capacity()) {
+        reserve(std::max(old_size + n, 2 * capacity()));
+      }
+    }
+    try {
+      for (auto&& t : r) columns_.push_back(std::forward<decltype(t)>(t));
+    } catch (...) {
+      columns_.erase(old_size, size());
+      throw;
+    }
+  }
+
+  void append(const soa_vector& other) {
+    columns_.append_columns(other.size(), [&other](auto tag) {
+      return other.template column<decltype(tag)::value>();
+    });
+  }
+
+  std::size_t size() const { return columns_.size(); }
+
+  bool empty() const { return size() == 0; }
+
+  // A tagged_tuple_ref_t, or a tagged_tuple of references and values if
+  // some columns, such as string columns, return values.
   auto operator[](std::size_t i) {
-    return tagged_tuple_ref_t<TaggedTuple>(
-        (ftsd::tag<Tags> = std::ref(ftsd::get<Tags>(vectors_)[i]))...);
+    if constexpr (references<soa_vector>) {
+      return tagged_tuple_ref_t<TaggedTuple>(
+          (ftsd::tag<Tags> = std::ref(column<Tags>()[i]))...);
+    } else {
+      return tagged_tuple<member<Tags, decltype(column<Tags>()[i])>...>(
+          (ftsd::tag<Tags> =
+               internal_soa_vector::row_member(column<Tags>()[i]))...);
+    }
   }
 
   auto operator[](std::size_t i) const {
-    return tagged_tuple_ref_t<TaggedTuple>(
-        (ftsd::tag<Tags> = std::ref(ftsd::get<Tags>(vectors_)[i]))...);
+    if constexpr (references<const soa_vector>) {
+      return tagged_tuple_ref_t<const TaggedTuple>(
+          (ftsd::tag<Tags> = std::cref(column<Tags>()[i]))...);
+    } else {
+      return tagged_tuple<member<Tags, decltype(column<Tags>()[i])>...>(
+          (ftsd::tag<Tags> =
+               internal_soa_vector::row_member(column<Tags>()[i]))...);
+    }
   }
 
   auto front() { return (*this)[0]; }
+  auto front() const { return (*this)[0]; }
   auto back() { return (*this)[size() - 1]; }
+  auto back() const { return (*this)[size() - 1]; }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+ private:
+  // True if every column of Self returns references to its values.
+  template <typename Self>
+  static constexpr bool references = (std::is_lvalue_reference_v<decltype(
+                                          std::declval<Self&>()
+                                              .template column<Tags>()[0])> &&
+                                      ...);
 };
 
-template <typename Tag, typename TaggedTuple>
-decltype(auto) get_impl(soa_vector<TaggedTuple>& s) {
-  return std::span{ftsd::get<Tag::value>(s.vectors())};
+template <typename Tag, typename TaggedTuple, typename Storage>
+auto get_impl(soa_vector<TaggedTuple, Storage>& s) {
+  return s.template column<Tag::value>();
 }
 
-template <typename Tag, typename TaggedTuple>
-auto get_impl(const soa_vector<TaggedTuple>& s) {
-  return std::span{ftsd::get<Tag::value>(s.vectors())};
+template <typename Tag, typename TaggedTuple, typename Storage>
+auto get_impl(const soa_vector<TaggedTuple, Storage>& s) {
+  return s.template column<Tag::value>();
 }
 
-template <typename Tag, typename TaggedTuple>
-auto get_impl(soa_vector<TaggedTuple>&& s) {
-  return std::span{ftsd::get<Tag::value>(std::move(s.vectors()))};
+template <typename Tag, typename TaggedTuple, typename Storage>
+auto get_impl(soa_vector<TaggedTuple, Storage>&& s) {
+  return s.template column<Tag::value>();
 }
 
 }  // namespace ftsd
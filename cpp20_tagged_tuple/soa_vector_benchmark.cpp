@@ -0,0 +1,661 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "aosoa_vector.h"
+#include "soa_filter.h"
+#include "soa_group_by.h"
+#include "soa_index.h"
+#include "soa_sort.h"
+#include "soa_string_storage.h"
+#include "soa_vector.h"
+#include "tagged_tuple.h"
+
+namespace ftsd {
+namespace {
+
+using Person =
+    tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                 member<"id", std::int64_t>, member<"score", double>>;
+
+using PersonVector = std::vector<Person>;
+using PersonSoaVector = soa_vector<Person>;
+using PersonBufferSoaVector = soa_vector<Person, buffer_storage>;
+
+std::vector<Person> MakePeople(std::int64_t count) {
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<std::int64_t> id(0, count);
+  std::uniform_real_distribution<double> score(0, 100);
+  std::vector<Person> people;
+  people.reserve(count);
+  for (std::int64_t i = 0; i < count; ++i) {
+    people.push_back({tag<"name"> = "Person " + std::to_string(i),
+                      tag<"address"> = "Somewhere", tag<"id"> = id(generator),
+                      tag<"score"> = score(generator)});
+  }
+  return people;
+}
+
+template <typename Container>
+Container MakeContainer(const std::vector<Person>& people) {
+  Container c;
+  if constexpr (!std::is_same_v<Container, PersonVector>) {
+    c.append(people);
+  } else {
+    c = people;
+  }
+  return c;
+}
+
+template <typename Container>
+void BM_PushBack(benchmark::State& state) {
+  auto people = MakePeople(state.range(0));
+  for (auto _ : state) {
+    Container c;
+    for (const auto& p : people) c.push_back(p);
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+// Rows of numbers, where the cost of growing the columns is not hidden by
+// copying strings.
+using Sample = tagged_tuple<member<"time", std::int64_t>, member<"x", double>,
+                            member<"y", double>, member<"flags", int>>;
+
+template <typename Storage>
+void BM_PushBackNumbers(benchmark::State& state) {
+  Sample sample{tag<"time"> = 1, tag<"x"> = 2.0, tag<"y"> = 3.0};
+  for (auto _ : state) {
+    soa_vector<Sample, Storage> c;
+    for (std::int64_t i = 0; i < state.range(0); ++i) c.push_back(sample);
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Container>
+void BM_Append(benchmark::State& state) {
+  auto people = MakePeople(state.range(0));
+  for (auto _ : state) {
+    auto c = MakeContainer<Container>(people);
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+template <typename Container>
+void BM_SumScores(benchmark::State& state) {
+  auto c = MakeContainer<Container>(MakePeople(state.range(0)));
+  for (auto _ : state) {
+    double sum = 0;
+    if constexpr (!std::is_same_v<Container, PersonVector>) {
+      for (double score : get<"score">(c)) sum += score;
+    } else {
+      for (const auto& p : c) sum += get<"score">(p);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+  state.SetBytesProcessed(state.iterations() * c.size() * sizeof(double));
+}
+
+template <typename Container>
+void BM_SortById(benchmark::State& state) {
+  auto people = MakePeople(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto c = MakeContainer<Container>(people);
+    state.ResumeTiming();
+    std::ranges::sort(c, {}, tag<"id">);
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+// Sorts by Key with std::ranges::sort for PersonVector, and sort_by
+// otherwise.
+template <typename Container, internal_tagged_tuple::fixed_string Key>
+void BM_SortByKey(benchmark::State& state) {
+  auto people = MakePeople(state.range(0));
+  // Destroys the sorted rows while the timer is paused.
+  Container c;
+  for (auto _ : state) {
+    state.PauseTiming();
+    c = MakeContainer<Container>(people);
+    state.ResumeTiming();
+    if constexpr (std::is_same_v<Container, PersonVector>) {
+      std::ranges::sort(c, {}, tag<Key>);
+    } else {
+      sort_by<Key>(c);
+    }
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+// range(1) is the number of threads.
+template <internal_tagged_tuple::fixed_string Key>
+void BM_ParallelSortBy(benchmark::State& state) {
+  auto people = MakePeople(state.range(0));
+  // Destroys the sorted rows while the timer is paused.
+  PersonSoaVector c;
+  for (auto _ : state) {
+    state.PauseTiming();
+    c = MakeContainer<PersonSoaVector>(people);
+    state.ResumeTiming();
+    parallel_sort_by<Key>(c, state.range(1));
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+void SortThreadArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"rows", "threads"});
+  int cores =
+      static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  for (int threads = 1; threads < cores; threads *= 2) {
+    b->Args({1 << 20, threads});
+  }
+  b->Args({1 << 20, cores})->UseRealTime();
+}
+
+using Particle =
+    tagged_tuple<member<"x", double>, member<"y", double>, member<"z", double>,
+                 member<"vx", double>, member<"vy", double>,
+                 member<"vz", double>, member<"mass", double>,
+                 member<"charge", double>>;
+
+template <typename Container>
+Container MakeParticles(std::int64_t count) {
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> value(-1, 1);
+  Container c;
+  for (std::int64_t i = 0; i < count; ++i) {
+    c.push_back({tag<"x"> = value(generator), tag<"y"> = value(generator),
+                 tag<"z"> = value(generator), tag<"vx"> = value(generator),
+                 tag<"vy"> = value(generator), tag<"vz"> = value(generator),
+                 tag<"mass"> = value(generator) + 2,
+                 tag<"charge"> = value(generator)});
+  }
+  return c;
+}
+
+double NarrowKernel(std::span<const double> mass) {
+  double sum = 0;
+  for (double m : mass) sum += m;
+  return sum;
+}
+
+double WideKernel(std::span<const double> x, std::span<const double> y,
+                  std::span<const double> z, std::span<const double> vx,
+                  std::span<const double> vy, std::span<const double> vz,
+                  std::span<const double> mass,
+                  std::span<const double> charge) {
+  double sum = 0;
+  for (std::size_t i = 0; i < mass.size(); ++i) {
+    sum += mass[i] * (vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]) +
+           charge[i] * (x[i] + y[i] + z[i]);
+  }
+  return sum;
+}
+
+// Calls f with the columns of the whole soa_vector, or once per tile of an
+// aosoa_vector.
+template <typename F, typename TaggedTuple, typename Storage>
+void ForEachColumnBlock(const soa_vector<TaggedTuple, Storage>& c, F f) {
+  f([&](auto tag) { return c.template column<decltype(tag)::value>(); });
+}
+
+template <typename F, typename TaggedTuple, std::size_t TileSize>
+void ForEachColumnBlock(const aosoa_vector<TaggedTuple, TileSize>& c, F f) {
+  for (std::size_t t = 0; t < c.tile_count(); ++t) {
+    f([&](auto tag) {
+      return c.template tile_column<decltype(tag)::value>(t);
+    });
+  }
+}
+
+template <typename Container>
+void BM_NarrowScan(benchmark::State& state) {
+  auto c = MakeParticles<Container>(state.range(0));
+  for (auto _ : state) {
+    double sum = 0;
+    ForEachColumnBlock(
+        c, [&](auto column) { sum += NarrowKernel(column(tag<"mass">)); });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+template <typename Container>
+void BM_WideScan(benchmark::State& state) {
+  auto c = MakeParticles<Container>(state.range(0));
+  for (auto _ : state) {
+    double sum = 0;
+    ForEachColumnBlock(c, [&](auto column) {
+      sum += WideKernel(column(tag<"x">), column(tag<"y">), column(tag<"z">),
+                        column(tag<"vx">), column(tag<"vy">),
+                        column(tag<"vz">), column(tag<"mass">),
+                        column(tag<"charge">));
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+using ParticleSoaVector = soa_vector<Particle>;
+using ParticleAosoaVector16 = aosoa_vector<Particle, 16>;
+using ParticleAosoaVector64 = aosoa_vector<Particle, 64>;
+using ParticleAosoaVector256 = aosoa_vector<Particle, 256>;
+
+// Selects about range(1) percent of the people with score, and then half of
+// those with id.
+auto MakeFilterPredicate(const benchmark::State& state) {
+  using namespace tag_relops;
+  return tag<"score"> < static_cast<double>(state.range(1)) &&
+         tag<"id"> >= state.range(0) / 2;
+}
+
+template <typename Container>
+void BM_FilterRowLoop(benchmark::State& state) {
+  auto c = MakeContainer<Container>(MakePeople(state.range(0)));
+  auto predicate = MakeFilterPredicate(state);
+  for (auto _ : state) {
+    std::vector<std::size_t> selection;
+    for (std::size_t i = 0; i < c.size(); ++i) {
+      if (predicate(c[i])) selection.push_back(i);
+    }
+    benchmark::DoNotOptimize(selection);
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+template <typename Container>
+void BM_Filter(benchmark::State& state) {
+  auto c = MakeContainer<Container>(MakePeople(state.range(0)));
+  auto predicate = MakeFilterPredicate(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter(c, predicate));
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+template <typename Container>
+void BM_FilterBitmap(benchmark::State& state) {
+  auto c = MakeContainer<Container>(MakePeople(state.range(0)));
+  auto predicate = MakeFilterPredicate(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter_bitmap(c, predicate));
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+template <typename Container>
+void BM_FilterCopy(benchmark::State& state) {
+  auto c = MakeContainer<Container>(MakePeople(state.range(0)));
+  auto predicate = MakeFilterPredicate(state);
+  for (auto _ : state) {
+    if constexpr (std::is_same_v<Container, PersonVector>) {
+      PersonVector selected;
+      std::ranges::copy_if(c, std::back_inserter(selected), predicate);
+      benchmark::DoNotOptimize(selected);
+    } else {
+      benchmark::DoNotOptimize(filter_copy(c, predicate));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+using Score =
+    tagged_tuple<member<"key", std::int64_t>, member<"id", std::int64_t>,
+                 member<"score", double>>;
+
+// range(0) rows with range(1) distinct keys.
+template <typename Container>
+Container MakeScores(const benchmark::State& state) {
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<std::int64_t> key(0, state.range(1) - 1);
+  std::uniform_real_distribution<double> score(0, 100);
+  Container c;
+  c.reserve(state.range(0));
+  for (std::int64_t i = 0; i < state.range(0); ++i) {
+    c.push_back({tag<"key"> = key(generator), tag<"id"> = i,
+                 tag<"score"> = score(generator)});
+  }
+  return c;
+}
+
+void BM_GroupByUnorderedMap(benchmark::State& state) {
+  auto rows = MakeScores<std::vector<Score>>(state);
+  struct totals {
+    double score = 0;
+    std::size_t count = 0;
+    std::int64_t max_id = 0;
+  };
+  for (auto _ : state) {
+    std::unordered_map<std::int64_t, totals> groups;
+    for (const auto& row : rows) {
+      auto& group = groups[get<"key">(row)];
+      group.score += get<"score">(row);
+      ++group.count;
+      group.max_id = std::max(group.max_id, get<"id">(row));
+    }
+    benchmark::DoNotOptimize(groups);
+  }
+  state.SetItemsProcessed(state.iterations() * rows.size());
+}
+
+void BM_GroupBy(benchmark::State& state) {
+  using namespace aggregates;
+  auto rows = MakeScores<soa_vector<Score>>(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        group_by<"key">(rows).aggregate(sum<"score">, count, max<"id">));
+  }
+  state.SetItemsProcessed(state.iterations() * rows.size());
+}
+
+// range(2) is the number of threads.
+void BM_GroupByParallel(benchmark::State& state) {
+  using namespace aggregates;
+  auto rows = MakeScores<soa_vector<Score>>(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(group_by<"key">(rows)
+                                 .parallel(state.range(2))
+                                 .aggregate(sum<"score">, count, max<"id">));
+  }
+  state.SetItemsProcessed(state.iterations() * rows.size());
+}
+
+void GroupByArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"rows", "keys"});
+  b->Args({10'000'000, 1'000})->Args({10'000'000, 1'000'000});
+  b->Unit(benchmark::kMillisecond);
+}
+
+void GroupByThreadArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"rows", "keys", "threads"});
+  int cores =
+      static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  for (std::int64_t keys : {1'000, 1'000'000}) {
+    for (int threads = 2; threads < cores; threads *= 2) {
+      b->Args({10'000'000, keys, threads});
+    }
+    b->Args({10'000'000, keys, std::max(cores, 2)});
+  }
+  b->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+using PersonHashIndexed = indexed_soa_vector<PersonSoaVector, hash_index<"id">>;
+using PersonOrderedIndexed =
+    indexed_soa_vector<PersonSoaVector, ordered_index<"id">,
+                       ordered_index<"score">>;
+using PersonFullyIndexed =
+    indexed_soa_vector<PersonSoaVector, hash_index<"id">,
+                       ordered_index<"score">>;
+
+// Looks up a random id among range(0) people, with a scan of the id column or
+// an index.
+template <typename Container>
+void BM_FindById(benchmark::State& state) {
+  auto c = MakeContainer<Container>(MakePeople(state.range(0)));
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<std::int64_t> id(0, state.range(0));
+  for (auto _ : state) {
+    auto value = id(generator);
+    if constexpr (std::is_same_v<Container, PersonSoaVector>) {
+      std::vector<std::size_t> found;
+      auto ids = c.template column<"id">();
+      for (std::size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] == value) found.push_back(i);
+      }
+      benchmark::DoNotOptimize(found);
+    } else {
+      benchmark::DoNotOptimize(c.template find<"id">(value));
+    }
+  }
+}
+
+// Selects the people with a score in a range of width range(1) / 100, about
+// range(1) per 10,000 of them, with filter or an ordered index.
+template <typename Container>
+void BM_RangeByScore(benchmark::State& state) {
+  using namespace tag_relops;
+  auto c = MakeContainer<Container>(MakePeople(state.range(0)));
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<double> score(0, 99);
+  auto width = static_cast<double>(state.range(1)) / 100;
+  for (auto _ : state) {
+    auto lo = score(generator);
+    if constexpr (std::is_same_v<Container, PersonSoaVector>) {
+      benchmark::DoNotOptimize(
+          filter(c, tag<"score"> >= lo && tag<"score"> < lo + width));
+    } else {
+      benchmark::DoNotOptimize(c.template range<"score">(lo, lo + width));
+    }
+  }
+}
+
+// The cost of keeping the indexes up to date, row by row.
+template <typename Container>
+void BM_IndexedPushBack(benchmark::State& state) {
+  auto people = MakePeople(state.range(0));
+  for (auto _ : state) {
+    Container c;
+    for (const auto& p : people) c.push_back(p);
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+template <typename Container>
+void BM_IndexedPopBack(benchmark::State& state) {
+  auto c = MakeContainer<Container>(MakePeople(state.range(0)));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = c;
+    state.ResumeTiming();
+    while (!copy.empty()) copy.pop_back();
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+// Appends range(0) rows at once, which rebuilds the ordered indexes.
+template <typename Container>
+void BM_IndexedAppend(benchmark::State& state) {
+  auto people = MakePeople(state.range(0));
+  for (auto _ : state) {
+    Container c;
+    c.append(people);
+    benchmark::DoNotOptimize(c);
+  }
+  state.SetItemsProcessed(state.iterations() * people.size());
+}
+
+using Resident =
+    tagged_tuple<member<"name", std::string>, member<"city", std::string>,
+                 member<"id", std::int64_t>>;
+
+using ResidentSoaVector = soa_vector<Resident>;
+using ResidentArenaSoaVector = soa_vector<Resident, string_arena_storage<>>;
+using ResidentDictionarySoaVector =
+    soa_vector<Resident, string_arena_storage<"city">>;
+
+// range(0) residents with unique names, too long for the small string
+// optimization, and one of 100 cities.
+template <typename Container>
+Container MakeResidents(std::int64_t count) {
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> city(0, 99);
+  Container c;
+  c.reserve(count);
+  for (std::int64_t i = 0; i < count; ++i) {
+    c.push_back(Resident(
+        tag<"name"> = "Resident number " + std::to_string(i),
+        tag<"city"> = "City of somewhere " + std::to_string(city(generator)),
+        tag<"id"> = i));
+  }
+  return c;
+}
+
+// The bytes that the values of column Tag take, including the buffers that
+// std::string allocates, but not the unused capacity of the columns.
+template <internal_tagged_tuple::fixed_string Tag, typename Container>
+std::size_t StringColumnBytes(const Container& c) {
+  auto column = get<Tag>(c);
+  if constexpr (requires { column.base().codes(); }) {
+    const auto& dictionary = column.base().dictionary();
+    return column.base().codes().size_bytes() +
+           dictionary.offsets().size_bytes() + dictionary.chars().size();
+  } else if constexpr (requires { column.base().offsets(); }) {
+    return column.base().offsets().size_bytes() + column.base().chars().size();
+  } else {
+    std::size_t bytes = column.size_bytes();
+    for (const auto& s : column) {
+      auto object = reinterpret_cast<const char*>(&s);
+      bool small = object <= s.data() && s.data() < object + sizeof(s);
+      if (!small) bytes += s.capacity() + 1;
+    }
+    return bytes;
+  }
+}
+
+// Reads every string of column Tag, and reports the bytes per row.
+template <typename Container, internal_tagged_tuple::fixed_string Tag>
+void BM_StringScan(benchmark::State& state) {
+  auto c = MakeResidents<Container>(state.range(0));
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (std::string_view s : get<Tag>(c)) total += s.size() + s.back();
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+  state.counters["bytes_per_row"] =
+      static_cast<double>(StringColumnBytes<Tag>(c)) / c.size();
+}
+
+// Selects the rows whose column Tag equals that of a row in the middle.
+template <typename Container, internal_tagged_tuple::fixed_string Tag>
+void BM_StringEqualityFilter(benchmark::State& state) {
+  using namespace tag_relops;
+  auto c = MakeResidents<Container>(state.range(0));
+  std::string value(get<Tag>(c[c.size() / 2]));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter(c, tag<Tag> == value));
+  }
+  state.SetItemsProcessed(state.iterations() * c.size());
+}
+
+BENCHMARK_TEMPLATE(BM_PushBack, PersonVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PushBack, PersonSoaVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PushBack, PersonBufferSoaVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PushBackNumbers, vector_storage)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_PushBackNumbers, buffer_storage)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_Append, PersonVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_Append, PersonSoaVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_Append, PersonBufferSoaVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_SumScores, PersonVector)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SumScores, PersonSoaVector)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SumScores, PersonBufferSoaVector)
+    ->Arg(1 << 16)
+    ->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SortById, PersonVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_SortById, PersonSoaVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_SortById, PersonBufferSoaVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_SortByKey, PersonVector, "id")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SortByKey, PersonSoaVector, "id")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SortByKey, PersonVector, "score")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SortByKey, PersonSoaVector, "score")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SortByKey, PersonVector, "name")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SortByKey, PersonSoaVector, "name")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_ParallelSortBy, "id")->Apply(SortThreadArgs);
+BENCHMARK_TEMPLATE(BM_ParallelSortBy, "name")->Apply(SortThreadArgs);
+
+BENCHMARK_TEMPLATE(BM_NarrowScan, ParticleSoaVector)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_NarrowScan, ParticleAosoaVector16)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_NarrowScan, ParticleAosoaVector64)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_NarrowScan, ParticleAosoaVector256)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_WideScan, ParticleSoaVector)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_WideScan, ParticleAosoaVector16)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_WideScan, ParticleAosoaVector64)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_WideScan, ParticleAosoaVector256)->Arg(1 << 20);
+
+BENCHMARK_TEMPLATE(BM_FilterRowLoop, PersonVector)
+    ->Args({1 << 20, 1})
+    ->Args({1 << 20, 50});
+BENCHMARK_TEMPLATE(BM_FilterRowLoop, PersonSoaVector)
+    ->Args({1 << 20, 1})
+    ->Args({1 << 20, 50});
+BENCHMARK_TEMPLATE(BM_Filter, PersonSoaVector)
+    ->Args({1 << 20, 1})
+    ->Args({1 << 20, 50});
+BENCHMARK_TEMPLATE(BM_FilterBitmap, PersonSoaVector)
+    ->Args({1 << 20, 1})
+    ->Args({1 << 20, 50});
+BENCHMARK_TEMPLATE(BM_FilterCopy, PersonVector)
+    ->Args({1 << 20, 1})
+    ->Args({1 << 20, 50});
+BENCHMARK_TEMPLATE(BM_FilterCopy, PersonSoaVector)
+    ->Args({1 << 20, 1})
+    ->Args({1 << 20, 50});
+
+BENCHMARK(BM_GroupByUnorderedMap)->Apply(GroupByArgs);
+BENCHMARK(BM_GroupBy)->Apply(GroupByArgs);
+BENCHMARK(BM_GroupByParallel)->Apply(GroupByThreadArgs);
+
+BENCHMARK_TEMPLATE(BM_FindById, PersonSoaVector)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_FindById, PersonHashIndexed)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_FindById, PersonOrderedIndexed)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_RangeByScore, PersonSoaVector)
+    ->Args({1 << 20, 1})
+    ->Args({1 << 20, 100});
+BENCHMARK_TEMPLATE(BM_RangeByScore, PersonOrderedIndexed)
+    ->Args({1 << 20, 1})
+    ->Args({1 << 20, 100});
+BENCHMARK_TEMPLATE(BM_IndexedPushBack, PersonSoaVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedPushBack, PersonHashIndexed)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedPushBack, PersonOrderedIndexed)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedPushBack, PersonFullyIndexed)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedPopBack, PersonSoaVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedPopBack, PersonHashIndexed)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedPopBack, PersonOrderedIndexed)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedPopBack, PersonFullyIndexed)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedAppend, PersonSoaVector)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedAppend, PersonHashIndexed)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedAppend, PersonOrderedIndexed)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_IndexedAppend, PersonFullyIndexed)->Arg(1 << 16);
+
+BENCHMARK_TEMPLATE(BM_StringScan, ResidentSoaVector, "name")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StringScan, ResidentArenaSoaVector, "name")
+    ->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StringScan, ResidentSoaVector, "city")->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StringScan, ResidentArenaSoaVector, "city")
+    ->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StringScan, ResidentDictionarySoaVector, "city")
+    ->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StringEqualityFilter, ResidentSoaVector, "name")
+    ->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StringEqualityFilter, ResidentArenaSoaVector, "name")
+    ->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StringEqualityFilter, ResidentSoaVector, "city")
+    ->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StringEqualityFilter, ResidentArenaSoaVector, "city")
+    ->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_StringEqualityFilter, ResidentDictionarySoaVector,
+                   "city")
+    ->Arg(1 << 20);
+
+}  // namespace
+}  // namespace ftsd
+
+BENCHMARK_MAIN();
@@ -1,10 +1,12 @@
 #pragma once
 #include <algorithm>
 #include <array>
+#include <concepts>
 #include <cstdint>
 #include <optional>
 #include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace ftsd {
@@ -109,6 +111,20 @@ struct optional_no_ref<T&> {
 template <typename T>
 using optional_no_ref_t = typename optional_no_ref<T>::type;
 
+// The value of a member of another tagged_tuple, for a member of type T.
+// Like the converting constructors of std::tuple, a value that does not
+// convert implicitly to T is converted explicitly, as a std::string_view is
+// to a std::string.
+template <typename T, typename U>
+constexpr decltype(auto) convert_member(U&& value) {
+  if constexpr (std::is_reference_v<T> || std::is_convertible_v<U, T> ||
+                !std::is_constructible_v<T, U>) {
+    return std::forward<U>(value);
+  } else {
+    return T(std::forward<U>(value));
+  }
+}
+
 template <typename Tag, typename T, auto Init = default_init<T>>
 struct member_impl {
   static constexpr decltype(Init) init = Init;
@@ -175,20 +191,27 @@ struct member_impl {
   } : value_(Init(self)) {
   }
   constexpr member_impl(const member_impl&) = default;
-  constexpr member_impl& operator=(const member_impl&) = default;
+  constexpr member_impl& operator=(const member_impl&) requires(
+      !std::is_reference_v<T>) = default;
+  // Like std::tuple, assigning a reference member assigns through it.
+  constexpr member_impl& operator=(const member_impl& other) requires(
+      std::is_reference_v<T>) {
+    value_ = other.value_;
+    return *this;
+  }
   constexpr member_impl(member_impl&&) = default;
   constexpr member_impl& operator=(member_impl&&) = default;
   template <typename Self, typename OtherT, auto OtherInit>
   constexpr member_impl(Self& self,
                         const member_impl<Tag, OtherT, OtherInit>& other)
-      : member_impl(self, other.value_) {}
+      : member_impl(self, convert_member<T>(other.value_)) {}
   template <typename Self, typename OtherT, auto OtherInit>
   constexpr member_impl(Self& self, member_impl<Tag, OtherT, OtherInit>& other)
-      : member_impl(self, other.value_) {}
+      : member_impl(self, convert_member<T>(other.value_)) {}
 
   template <typename Self, typename OtherT, auto OtherInit>
   constexpr member_impl(Self& self, member_impl<Tag, OtherT, OtherInit>&& other)
-      : member_impl(self, std::move(other.value_)){};
+      : member_impl(self, convert_member<T>(std::move(other.value_))){};
   template <typename OtherT, auto OtherInit>
   constexpr member_impl& operator=(
       const member_impl<Tag, OtherT, OtherInit>& other) {
@@ -379,6 +402,9 @@ struct tagged_tuple_base : member_to_impl_t<Self, Members>... {
   static constexpr auto size() { return sizeof...(Members); }
 };
 
+template <typename Tag, typename T, auto Init>
+T tagged_tuple_value_type_impl(member_impl<Tag, T, Init>&);
+
 template <typename Tag, typename T, auto Init>
 constexpr decltype(auto) get_impl(member_impl<Tag, T, Init>& m) {
   return (m.value());
@@ -404,6 +430,15 @@ constexpr decltype(auto) get(S&& s) {
   return get_impl<tuple_tag<fixed_string<fs.size()>(fs)>>(std::forward<S>(s));
 }
 
+// Moves a member of an rvalue tagged_tuple, and copies it if the member is a
+// reference, like std::forward does.
+template <fixed_string fs, typename Tuple>
+constexpr decltype(auto) forward_member(Tuple& t) {
+  using value_type = decltype(tagged_tuple_value_type_impl<
+                              tuple_tag<fixed_string<fs.size()>(fs)>>(t));
+  return static_cast<value_type&&>(get<fs>(t));
+}
+
 template <typename... Members>
 struct tagged_tuple : tagged_tuple_base<tagged_tuple<Members...>, Members...> {
   using super = tagged_tuple_base<tagged_tuple, Members...>;
@@ -423,6 +458,39 @@ struct tagged_tuple : tagged_tuple_base<tagged_tuple<Members...>, Members...> {
   constexpr tagged_tuple(tagged_tuple&&) = default;
   constexpr tagged_tuple& operator=(tagged_tuple&& other) = default;
 
+  // Assigns member by member from a tagged_tuple with the same tags, for
+  // example a tagged_tuple_ref_t from its value.
+  template <typename... OtherMembers>
+  constexpr tagged_tuple& operator=(
+      const tagged_tuple<OtherMembers...>& other) {
+    ((get<Members::fs>(*this) = get<Members::fs>(other)), ...);
+    return *this;
+  }
+
+  template <typename... OtherMembers>
+  constexpr tagged_tuple& operator=(tagged_tuple<OtherMembers...>&& other) {
+    ((get<Members::fs>(*this) = forward_member<Members::fs>(other)), ...);
+    return *this;
+  }
+
+  // A tagged_tuple_ref_t is returned by value from proxy iterators, and
+  // assigning to it assigns to what it refers to, even when it is const.
+  template <typename... OtherMembers>
+  constexpr const tagged_tuple& operator=(
+      const tagged_tuple<OtherMembers...>& other) const
+      requires(std::is_reference_v<typename Members::type>&&...) {
+    ((get<Members::fs>(*this) = get<Members::fs>(other)), ...);
+    return *this;
+  }
+
+  template <typename... OtherMembers>
+  constexpr const tagged_tuple& operator=(
+      tagged_tuple<OtherMembers...>&& other) const
+      requires(std::is_reference_v<typename Members::type>&&...) {
+    ((get<Members::fs>(*this) = forward_member<Members::fs>(other)), ...);
+    return *this;
+  }
+
   template <typename Tag>
   constexpr auto& operator[](Tag) {
     return get<Tag::value>(*this);
@@ -434,9 +502,6 @@ struct tagged_tuple : tagged_tuple_base<tagged_tuple<Members...>, Members...> {
   }
 };
 
-template <typename Tag, typename T, auto Init>
-T tagged_tuple_value_type_impl(member_impl<Tag, T, Init>&);
-
 // A lambda passed to a template must be stateless and default constructible
 // anyway.
 template <typename Tag, typename T, auto Init>
@@ -491,6 +556,49 @@ struct tagged_tuple_ref<const tagged_tuple<member<Tags, T, Init>...>> {
 template <typename TaggedTuple>
 using tagged_tuple_ref_t = typename tagged_tuple_ref<TaggedTuple>::type;
 
+// Swaps what two tagged_tuple_ref_t refer to. The const overload swaps the
+// proxies returned by value from soa_vector iterators.
+template <typename... Members>
+requires(std::is_reference_v<typename Members::type>&&...)
+constexpr void swap(const tagged_tuple<Members...>& a,
+                    const tagged_tuple<Members...>& b) {
+  using std::swap;
+  (swap(get<Members::fs>(a), get<Members::fs>(b)), ...);
+}
+
+template <typename... Members>
+requires(std::is_reference_v<typename Members::type>&&...)
+constexpr void swap(tagged_tuple<Members...>& a, tagged_tuple<Members...>& b) {
+  swap(std::as_const(a), std::as_const(b));
+}
+
+template <typename Ref, typename Value>
+struct is_tagged_tuple_view_of : std::false_type {};
+
+// A row with the members of Value, which has no references, each either a
+// reference to the member or a value, such as a std::string_view, that the
+// member can be made from, and at least one of them a value.
+template <auto... Tags, typename... R, auto... RInits, typename... T,
+          auto... TInits>
+struct is_tagged_tuple_view_of<tagged_tuple<member<Tags, R, RInits>...>,
+                               tagged_tuple<member<Tags, T, TInits>...>>
+    : std::bool_constant<(... && (std::is_reference_v<R>
+                                      ? std::same_as<std::remove_cvref_t<R>, T>
+                                      : !std::same_as<R, T> &&
+                                            std::constructible_from<T, R>)) &&
+                         (... || !std::is_reference_v<R>) &&
+                         (... && !std::is_reference_v<T>)> {};
+
+// True if Ref is the tagged_tuple_ref_t of the tagged_tuple Value, or a row
+// like it whose values of some members are views, as the rows of a
+// soa_vector with string_arena_storage are.
+template <typename Ref, typename Value>
+concept tagged_tuple_ref_of =
+    !std::same_as<Ref, Value> &&
+    (std::same_as<Ref, typename tagged_tuple_ref<Value>::type> ||
+     std::same_as<Ref, typename tagged_tuple_ref<const Value>::type> ||
+     is_tagged_tuple_view_of<Ref, Value>::value);
+
 template <fixed_string fs>
 inline constexpr auto tag = tuple_tag<fixed_string<fs.size()>(fs)>{};
 
@@ -514,8 +622,13 @@ struct tag_comparator_predicate {
   TagOrValue2 tag_or_value2;
   template <typename TS>
   bool operator()(const TS& ts) const {
-    const auto& a = get_value_for_comparison(tag_or_value1, ts);
-    const auto& b = get_value_for_comparison(tag_or_value2, ts);
+    return compare(get_value_for_comparison(tag_or_value1, ts),
+                   get_value_for_comparison(tag_or_value2, ts));
+  }
+
+  // Compares two values, such as the values of one row of two columns.
+  template <typename A, typename B>
+  constexpr static bool compare(const A& a, const B& b) {
     if constexpr (comparison == tag_comparison::eq) {
       return a == b;
     }
@@ -543,6 +656,39 @@ constexpr auto make_tag_comparator_predicate(T1 a, T2 b) {
                                                       std::move(b)};
 }
 
+enum class tag_logical { and_, or_ };
+
+// Combines two predicates with && or ||, which short circuit as usual when a
+// row is evaluated.
+template <typename Predicate1, typename Predicate2, tag_logical logical>
+struct tag_logical_predicate {
+  Predicate1 predicate1;
+  Predicate2 predicate2;
+  template <typename TS>
+  bool operator()(const TS& ts) const {
+    if constexpr (logical == tag_logical::and_) {
+      return predicate1(ts) && predicate2(ts);
+    } else {
+      return predicate1(ts) || predicate2(ts);
+    }
+  }
+};
+
+template <typename T>
+struct is_tag_predicate : std::false_type {};
+
+template <typename TagOrValue1, typename TagOrValue2, tag_comparison comparison>
+struct is_tag_predicate<
+    tag_comparator_predicate<TagOrValue1, TagOrValue2, comparison>>
+    : std::true_type {};
+
+template <typename Predicate1, typename Predicate2, tag_logical logical>
+struct is_tag_predicate<tag_logical_predicate<Predicate1, Predicate2, logical>>
+    : std::true_type {};
+
+template <typename T>
+constexpr bool is_tag_predicate_v = is_tag_predicate<T>::value;
+
 namespace tag_relops {
 // Compare two tags
 template <typename A, typename B>
@@ -581,6 +727,21 @@ constexpr auto operator>(A a, B b) {
   return make_tag_comparator_predicate<tag_comparison::gt>(a, b);
 }
 
+// Combine two predicates
+template <typename A, typename B>
+requires is_tag_predicate_v<A> && is_tag_predicate_v<B>
+constexpr auto operator&&(A a, B b) {
+  return tag_logical_predicate<A, B, tag_logical::and_>{std::move(a),
+                                                        std::move(b)};
+}
+
+template <typename A, typename B>
+requires is_tag_predicate_v<A> && is_tag_predicate_v<B>
+constexpr auto operator||(A a, B b) {
+  return tag_logical_predicate<A, B, tag_logical::or_>{std::move(a),
+                                                       std::move(b)};
+}
+
 }  // namespace tag_relops
 
 }  // namespace internal_tagged_tuple
@@ -605,3 +766,23 @@ constexpr auto operator""_tag() {
 }  // namespace literals
 
 }  // namespace ftsd
+
+// A tagged_tuple_ref_t and its tagged_tuple have the tagged_tuple as their
+// common reference, as needed by iterators that return tagged_tuple_ref_t.
+template <typename... A, typename... B, template <typename> class AQual,
+          template <typename> class BQual>
+requires ftsd::internal_tagged_tuple::tagged_tuple_ref_of<
+    ftsd::tagged_tuple<A...>, ftsd::tagged_tuple<B...>>
+struct std::basic_common_reference<ftsd::tagged_tuple<A...>,
+                                   ftsd::tagged_tuple<B...>, AQual, BQual> {
+  using type = ftsd::tagged_tuple<B...>;
+};
+
+template <typename... A, typename... B, template <typename> class AQual,
+          template <typename> class BQual>
+requires ftsd::internal_tagged_tuple::tagged_tuple_ref_of<
+    ftsd::tagged_tuple<B...>, ftsd::tagged_tuple<A...>>
+struct std::basic_common_reference<ftsd::tagged_tuple<A...>,
+                                   ftsd::tagged_tuple<B...>, AQual, BQual> {
+  using type = ftsd::tagged_tuple<A...>;
+};
@@ -3,6 +3,22 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "aosoa_vector.h"
+#include "soa_filter.h"
+#include "soa_group_by.h"
+#include "soa_index.h"
+#include "soa_sort.h"
+#include "soa_string_storage.h"
 #include "soa_vector.h"
 #include "to_from_nlohmann_json.h"
 
@@ -120,6 +136,11 @@ TEST(TaggedStruct, RelopsPredicate) {
   EXPECT_TRUE((15 >= tag<"a">)(ctad));
   EXPECT_TRUE((15 == tag<"a">)(ctad));
   EXPECT_FALSE((15 != tag<"a">)(ctad));
+
+  EXPECT_TRUE((tag<"a"> == 15 && tag<"b"> == "Hello ctad")(ctad));
+  EXPECT_FALSE((tag<"a"> == 15 && tag<"b"> == "Hello")(ctad));
+  EXPECT_TRUE((tag<"a"> != 15 || tag<"b"> == "Hello ctad")(ctad));
+  EXPECT_FALSE((tag<"a"> != 15 || tag<"b"> == "Hello")(ctad));
 }
 
 TEST(TaggedStruct, Apply) {
@@ -165,6 +186,644 @@ TEST(SoaVector, Basic) {
   EXPECT_EQ(*std::max_element(scores.begin(), scores.end()), 12.5);
 }
 
+TEST(SoaVector, BulkApi) {
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                   member<"id", std::int64_t>, member<"score", double>>;
+
+  soa_vector<Person> v;
+  v.reserve(10);
+  EXPECT_GE(v.capacity(), 10);
+  v.emplace_back(tag<"name"> = "John", tag<"id"> = 1);
+  auto jane = v.emplace_back(tag<"name"> = "Jane", tag<"id"> = 3);
+  get<"score">(jane) = 5;
+  v.insert(v.begin() + 1, {tag<"name"> = "Jim", tag<"id"> = 2});
+  ASSERT_EQ(v.size(), 3);
+  EXPECT_EQ(get<"name">(v[1]), "Jim");
+  EXPECT_EQ(get<"score">(v[2]), 5);
+
+  v.erase(v.begin());
+  ASSERT_EQ(v.size(), 2);
+  EXPECT_EQ(get<"id">(v.front()), 2);
+
+  std::vector<Person> people{{tag<"name"> = "Ann", tag<"id"> = 4},
+                             {tag<"name"> = "Bob", tag<"id"> = 5}};
+  v.append(people);
+  v.append(people | std::views::filter(
+                        [](const Person& p) { return get<"id">(p) == 5; }));
+  ASSERT_EQ(v.size(), 5);
+  EXPECT_EQ(get<"name">(v[2]), "Ann");
+  EXPECT_EQ(get<"name">(v.back()), "Bob");
+  EXPECT_EQ(get<"name">(people[0]), "Ann");
+
+  soa_vector<Person> copy;
+  copy.append(v);
+  copy.append(std::as_const(v) | std::views::take(1));
+  EXPECT_EQ(copy.size(), 6);
+  EXPECT_EQ(get<"name">(copy[5]), "Jim");
+  EXPECT_EQ(get<"name">(v[0]), "Jim");
+
+  v.resize(7);
+  EXPECT_EQ(get<"name">(v[6]), "");
+  v.resize(8, {tag<"name"> = "Default"});
+  EXPECT_EQ(get<"name">(v[7]), "Default");
+  v.erase(v.begin() + 2, v.end());
+  EXPECT_EQ(v.size(), 2);
+}
+
+TEST(SoaVector, Sort) {
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                   member<"id", std::int64_t>, member<"score", double>>;
+
+  static_assert(std::ranges::random_access_range<soa_vector<Person>>);
+  static_assert(std::sortable<soa_vector<Person>::iterator, std::ranges::less,
+                              decltype(tag<"id">)>);
+
+  soa_vector<Person> v;
+  for (int id : {3, 1, 4, 5, 9, 2, 6, 8, 7, 0}) {
+    v.emplace_back(tag<"name"> = std::to_string(id), tag<"id"> = id);
+  }
+  auto check = [&] {
+    for (std::size_t i = 0; i < v.size(); ++i) {
+      EXPECT_EQ(get<"id">(v[i]), static_cast<std::int64_t>(i));
+      EXPECT_EQ(get<"name">(v[i]), std::to_string(i));
+    }
+  };
+  std::sort(v.begin(), v.end(), [](const auto& a, const auto& b) {
+    return get<"id">(a) < get<"id">(b);
+  });
+  check();
+
+  std::ranges::sort(v, std::ranges::greater{}, tag<"id">);
+  EXPECT_EQ(get<"id">(v.front()), 9);
+  std::ranges::sort(v, {}, tag<"name">);
+  check();
+
+  std::ranges::reverse(v);
+  EXPECT_EQ(get<"id">(v.front()), 9);
+
+  auto ids = v | std::views::transform(tag<"id">);
+  EXPECT_EQ(std::ranges::max(ids), 9);
+  const auto& cv = v;
+  EXPECT_EQ(std::ranges::find(cv, 4, tag<"id">) - cv.begin(), 5);
+}
+
+TEST(SoaVector, RefAssignment) {
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                   member<"id", std::int64_t>, member<"score", double>>;
+
+  soa_vector<Person> v;
+  v.emplace_back(tag<"name"> = "John", tag<"id"> = 1);
+  v.emplace_back(tag<"name"> = "Jane", tag<"id"> = 2);
+  v[0] = v[1];
+  EXPECT_EQ(get<"name">(v[0]), "Jane");
+  v[1] = Person{tag<"name"> = "Jim", tag<"id"> = 3};
+  EXPECT_EQ(get<"name">(v[1]), "Jim");
+  swap(v[0], v[1]);
+  EXPECT_EQ(get<"name">(v[0]), "Jim");
+  EXPECT_EQ(get<"id">(v[1]), 2);
+  Person p = v[0];
+  EXPECT_EQ(get<"name">(p), "Jim");
+  EXPECT_EQ(get<"name">(v[0]), "Jim");
+}
+
+TEST(SoaVector, AppendTemporaryRows) {
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"id", std::int64_t>>;
+
+  // The rows are temporaries, made again each time the range is read.
+  auto people = std::views::iota(0, 100) | std::views::transform([](int i) {
+                  return Person(
+                      tag<"name"> =
+                          "a name long enough to allocate " + std::to_string(i),
+                      tag<"id"> = i);
+                });
+  soa_vector<Person> v;
+  v.append(people);
+  ASSERT_EQ(v.size(), 100);
+  EXPECT_EQ(get<"name">(v[42]), "a name long enough to allocate 42");
+  EXPECT_EQ(get<"id">(v.back()), 99);
+
+  soa_vector<Person, buffer_storage> buffered;
+  buffered.append(people);
+  EXPECT_TRUE(std::ranges::equal(get<"name">(buffered), get<"name">(v)));
+}
+
+struct ThrowingCopy {
+  // Copies that succeed before one throws; negative for no limit.
+  static inline int copies_left = -1;
+
+  ThrowingCopy() = default;
+  explicit ThrowingCopy(std::string text) : text(std::move(text)) {}
+  ThrowingCopy(const ThrowingCopy& other) : text(other.text) {
+    if (copies_left-- == 0) throw std::runtime_error("copy");
+  }
+  ThrowingCopy(ThrowingCopy&&) = default;
+  ThrowingCopy& operator=(const ThrowingCopy&) = default;
+  ThrowingCopy& operator=(ThrowingCopy&&) = default;
+
+  friend auto operator<=>(const ThrowingCopy&,
+                          const ThrowingCopy&) = default;
+
+  std::string text;
+};
+
+TEST(SoaVector, RollsBackOnThrow) {
+  using Row = tagged_tuple<member<"name", std::string>,
+                           member<"value", ThrowingCopy>,
+                           member<"id", std::int64_t>>;
+
+  soa_vector<Row> v;
+  v.emplace_back(tag<"name"> = "first", tag<"id"> = 1);
+  auto expect_unchanged = [&v] {
+    EXPECT_EQ(get<"name">(v.vectors()).size(), 1);
+    EXPECT_EQ(get<"value">(v.vectors()).size(), 1);
+    EXPECT_EQ(get<"id">(v.vectors()).size(), 1);
+    EXPECT_EQ(get<"name">(v.back()), "first");
+  };
+  std::vector<Row> rows(3, Row{tag<"name"> = "appended", tag<"id"> = 2});
+  ThrowingCopy::copies_left = 1;
+  EXPECT_THROW(v.append(rows), std::runtime_error);
+  expect_unchanged();
+
+  ThrowingCopy::copies_left = 2;
+  EXPECT_THROW(v.resize(5), std::runtime_error);
+  expect_unchanged();
+
+  // Throws from each copy in turn, until the insert succeeds.
+  for (int copies = 0;; ++copies) {
+    ThrowingCopy::copies_left = copies;
+    try {
+      v.insert(v.begin(), rows[0]);
+      break;
+    } catch (const std::runtime_error&) {
+      expect_unchanged();
+    }
+  }
+  ThrowingCopy::copies_left = -1;
+  EXPECT_EQ(v.size(), 2);
+  EXPECT_EQ(get<"value">(v.vectors()).size(), 2);
+  EXPECT_EQ(get<"name">(v.front()), "appended");
+
+  // Appending 3 rows to 1 rebuilds the ordered index.
+  indexed_soa_vector<soa_vector<Row>, ordered_index<"value">> indexed;
+  ThrowingCopy key("key");
+  indexed.push_back(Row{tag<"value"> = key});
+  for (int copies = 0;; ++copies) {
+    ThrowingCopy::copies_left = copies;
+    try {
+      indexed.append(rows);
+      break;
+    } catch (const std::runtime_error&) {
+      ThrowingCopy::copies_left = -1;
+      EXPECT_EQ(indexed.size(), 1);
+      EXPECT_EQ(indexed.find<"value">(key), std::vector<std::size_t>{0});
+    }
+  }
+  ThrowingCopy::copies_left = -1;
+  EXPECT_EQ(indexed.size(), 4);
+  EXPECT_EQ(indexed.find<"value">(key), std::vector<std::size_t>{0});
+  EXPECT_EQ(indexed.find<"value">(ThrowingCopy()).size(), 3);
+}
+
+TEST(SoaVector, BufferStorage) {
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                   member<"id", std::int64_t>, member<"score", double>>;
+
+  soa_vector<Person, buffer_storage> v;
+  for (int id = 0; id < 100; ++id) {
+    v.emplace_back(tag<"name"> = std::to_string(id), tag<"id"> = id);
+  }
+  ASSERT_EQ(v.size(), 100);
+  EXPECT_GE(v.capacity(), 100);
+  for (auto address : {static_cast<const void*>(get<"name">(v).data()),
+                       static_cast<const void*>(get<"address">(v).data()),
+                       static_cast<const void*>(get<"id">(v).data()),
+                       static_cast<const void*>(get<"score">(v).data())}) {
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(address) %
+                  buffer_storage::alignment,
+              0);
+  }
+  EXPECT_EQ(get<"name">(v[99]), "99");
+
+  v.insert(v.begin() + 1, {tag<"name"> = "inserted", tag<"id"> = -1});
+  v.erase(v.begin() + 2, v.begin() + 50);
+  ASSERT_EQ(v.size(), 53);
+  EXPECT_EQ(get<"name">(v[1]), "inserted");
+  EXPECT_EQ(get<"id">(v[2]), 49);
+
+  auto copy = v;
+  std::ranges::sort(copy, std::ranges::greater{}, tag<"id">);
+  EXPECT_EQ(get<"id">(copy.front()), 99);
+  EXPECT_EQ(get<"id">(v.back()), 99);
+
+  v.append(copy);
+  v.append(std::vector<Person>{{tag<"name"> = "last"}});
+  EXPECT_EQ(v.size(), 107);
+  EXPECT_EQ(get<"name">(v.back()), "last");
+
+  v.resize(110, {tag<"name"> = "resized"});
+  EXPECT_EQ(get<"name">(v[109]), "resized");
+  v.resize(2);
+  v.pop_back();
+  EXPECT_EQ(v.size(), 1);
+  auto moved = std::move(v);
+  EXPECT_EQ(get<"name">(moved[0]), "0");
+}
+
+TEST(AosoaVector, Basic) {
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                   member<"id", std::int64_t>, member<"score", double>>;
+
+  aosoa_vector<Person, 4> v;
+  for (int id = 0; id < 10; ++id) {
+    v.emplace_back(tag<"name"> = std::to_string(id), tag<"id"> = id,
+                   tag<"score"> = id * 0.5);
+  }
+  ASSERT_EQ(v.size(), 10);
+  ASSERT_EQ(v.tile_count(), 3);
+  EXPECT_EQ(get<"name">(v[5]), "5");
+  EXPECT_EQ(v.tile_column<"id">(1).size(), 4);
+  EXPECT_EQ(v.tile_column<"id">(2).size(), 2);
+  EXPECT_EQ(v.tile_column<"id">(2)[1], 9);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(v.tile_column<"score">(1).data()) %
+                buffer_storage::alignment,
+            0);
+
+  auto scores = get<"score">(v);
+  EXPECT_EQ(*std::ranges::max_element(scores), 4.5);
+  EXPECT_EQ(std::ranges::distance(scores), 10);
+
+  std::ranges::sort(v, std::ranges::greater{}, tag<"id">);
+  EXPECT_EQ(get<"name">(v.front()), "9");
+  EXPECT_EQ(get<"name">(v.back()), "0");
+
+  v.pop_back();
+  v.pop_back();
+  EXPECT_EQ(v.tile_count(), 2);
+  v.push_back({tag<"name"> = "new"});
+  EXPECT_EQ(get<"name">(v[8]), "new");
+  EXPECT_EQ(v.tile_count(), 3);
+}
+
+TEST(SoaVector, Filter) {
+  using namespace tag_relops;
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                   member<"id", std::int64_t>, member<"score", double>>;
+
+  soa_vector<Person> v;
+  for (int id = 0; id < 150; ++id) {
+    v.emplace_back(tag<"name"> = std::to_string(id), tag<"id"> = id,
+                   tag<"score"> = id % 10 * 1.5);
+  }
+
+  auto predicate =
+      (tag<"score"> > 10.0 && tag<"id"> < 100) || tag<"name"> == "149";
+  std::vector<std::size_t> expected;
+  for (std::size_t i = 0; i < v.size(); ++i) {
+    if (predicate(v[i])) expected.push_back(i);
+  }
+  ASSERT_EQ(expected.size(), 31);
+
+  auto selection = filter_bitmap(v, predicate);
+  EXPECT_EQ(selection.size(), 150);
+  EXPECT_EQ(selection.count(), expected.size());
+  EXPECT_TRUE(selection[149]);
+  EXPECT_FALSE(selection[148]);
+  EXPECT_EQ(selection.indices(), expected);
+  EXPECT_EQ(filter(v, predicate), expected);
+  EXPECT_EQ(filter(v, [](const auto& row) { return get<"id">(row) == 3; }),
+            std::vector<std::size_t>{3});
+  EXPECT_EQ(filter(v, tag<"id"> < tag<"score">).size(), 9);
+
+  auto copy = filter_copy(v, predicate);
+  ASSERT_EQ(copy.size(), expected.size());
+  EXPECT_EQ(get<"name">(copy.front()), "7");
+  EXPECT_EQ(get<"name">(copy.back()), "149");
+  EXPECT_EQ(get<"name">(v.back()), "149");
+}
+
+TEST(SoaVector, GroupBy) {
+  using namespace aggregates;
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                   member<"id", std::int64_t>, member<"score", double>>;
+
+  soa_vector<Person> v;
+  for (int id = 0; id < 1000; ++id) {
+    v.emplace_back(tag<"name"> = std::to_string(id % 7), tag<"id"> = id,
+                   tag<"score"> = id % 3 * 1.0);
+  }
+
+  auto totals = group_by<"name">(v).aggregate(sum<"score">, count, max<"id">,
+                                              min<"id">, mean<"id">);
+  ASSERT_EQ(totals.size(), 7);
+  EXPECT_EQ(get<"name">(totals[0]), "0");
+  EXPECT_EQ(get<"count">(totals[0]), 143);
+  EXPECT_EQ(get<"min_id">(totals[0]), 0);
+  EXPECT_EQ(get<"max_id">(totals[0]), 994);
+  EXPECT_EQ(get<"mean_id">(totals[0]), 497);
+  EXPECT_EQ(get<"count">(totals[6]), 142);
+  EXPECT_EQ(get<"min_id">(totals[6]), 6);
+  std::int64_t ids = 0;
+  for (int id = 3; id < 1000; id += 7) ids += id % 3;
+  EXPECT_EQ(get<"sum_score">(totals[3]), ids);
+
+  auto by_id = group_by<"id">(v).aggregate(count);
+  EXPECT_EQ(by_id.size(), 1000);
+  EXPECT_TRUE(std::ranges::all_of(get<"count">(by_id),
+                                  [](std::size_t n) { return n == 1; }));
+
+  auto parallel =
+      group_by<"name">(v).parallel(3).aggregate(sum<"score">, count,
+                                                max<"id">);
+  ASSERT_EQ(parallel.size(), 7);
+  std::ranges::sort(parallel, {}, tag<"name">);
+  for (std::size_t g = 0; g < 7; ++g) {
+    EXPECT_EQ(get<"name">(parallel[g]), get<"name">(totals[g]));
+    EXPECT_EQ(get<"sum_score">(parallel[g]), get<"sum_score">(totals[g]));
+    EXPECT_EQ(get<"count">(parallel[g]), get<"count">(totals[g]));
+    EXPECT_EQ(get<"max_id">(parallel[g]), get<"max_id">(totals[g]));
+  }
+  EXPECT_EQ(group_by<"id">(v).parallel(2).aggregate(count).size(), 1000);
+  EXPECT_TRUE(group_by<"id">(soa_vector<Person>()).aggregate(count).empty());
+}
+
+TEST(SoaVector, SortBy) {
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                   member<"id", std::int64_t>, member<"score", double>>;
+
+  soa_vector<Person> v;
+  for (int i = 0; i < 100; ++i) {
+    v.emplace_back(tag<"name"> = std::to_string(i % 10),
+                   tag<"address"> = std::to_string(i), tag<"id"> = 50 - i,
+                   tag<"score"> = (i % 7 - 3) * 1.5);
+  }
+  auto by_address = [](const auto& row) { return get<"address">(row); };
+
+  auto ids = v;
+  sort_by<"id">(ids);
+  EXPECT_TRUE(std::ranges::is_sorted(get<"id">(ids)));
+  EXPECT_EQ(get<"address">(ids.front()), "99");
+  EXPECT_EQ(get<"id">(ids.front()), -49);
+
+  auto scores = v;
+  stable_sort_by<"score", "id">(scores);
+  EXPECT_TRUE(std::ranges::is_sorted(get<"score">(scores)));
+  EXPECT_EQ(get<"score">(scores.front()), -4.5);
+  EXPECT_EQ(get<"address">(scores.front()), "98");
+
+  auto names = v;
+  stable_sort_by<"name">(names);
+  EXPECT_EQ(get<"address">(names[0]), "0");
+  EXPECT_EQ(get<"address">(names[1]), "10");
+  EXPECT_EQ(get<"address">(names[10]), "1");
+
+  auto names_ids = v;
+  sort_by<"name", "id">(names_ids);
+  EXPECT_EQ(get<"address">(names_ids[0]), "90");
+  EXPECT_EQ(get<"address">(names_ids[9]), "0");
+
+  auto permutation = sort_permutation<"id">(v);
+  EXPECT_EQ(permutation.front(), 99);
+  EXPECT_EQ(permutation.back(), 0);
+
+  for (std::size_t threads : {1, 2, 3, 8}) {
+    auto parallel = v;
+    parallel_sort_by<"name">(parallel, threads);
+    EXPECT_TRUE(std::ranges::equal(parallel, names, {}, by_address,
+                                   by_address));
+    parallel = v;
+    parallel_sort_by<"score", "id">(parallel, threads);
+    EXPECT_TRUE(std::ranges::equal(parallel, scores, {}, by_address,
+                                   by_address));
+  }
+
+  // -0.0 equals 0.0, and NaNs, even negative ones, come last.
+  auto nan = std::numeric_limits<double>::quiet_NaN();
+  soa_vector<Person> special;
+  for (int i = 0; i < 40; ++i) {
+    double score[] = {nan, 0.0, -nan, -0.0, 1.0, -1.0};
+    special.emplace_back(tag<"address"> = std::to_string(i),
+                         tag<"score"> = score[i % 6]);
+  }
+  auto sorted = special;
+  stable_sort_by<"score">(sorted);
+  EXPECT_EQ(get<"address">(sorted[6]), "1");
+  EXPECT_EQ(get<"address">(sorted[7]), "3");
+  EXPECT_TRUE(std::signbit(get<"score">(sorted[7])));
+  EXPECT_TRUE(std::isnan(get<"score">(sorted.back())));
+  EXPECT_EQ(get<"address">(sorted[sorted.size() - 14]), "0");
+  EXPECT_EQ(get<"address">(sorted[sorted.size() - 13]), "2");
+  for (std::size_t threads : {2, 3, 8}) {
+    auto parallel = special;
+    parallel_sort_by<"score">(parallel, threads);
+    EXPECT_TRUE(std::ranges::equal(parallel, sorted, {}, by_address,
+                                   by_address));
+  }
+}
+
+TEST(SoaVector, Index) {
+  using Person =
+      tagged_tuple<member<"name", std::string>, member<"address", std::string>,
+                   member<"id", std::int64_t>, member<"score", double>>;
+
+  indexed_soa_vector<soa_vector<Person>, hash_index<"id">,
+                     ordered_index<"score">, ordered_index<"name">>
+      v;
+  auto expect_consistent = [&v] {
+    for (std::int64_t id = -1; id < 40; ++id) {
+      std::vector<std::size_t> expected;
+      for (std::size_t i = 0; i < v.size(); ++i) {
+        if (get<"id">(v[i]) == id) expected.push_back(i);
+      }
+      auto found = v.find<"id">(id);
+      std::ranges::sort(found);
+      EXPECT_EQ(found, expected);
+    }
+    for (double lo = -1; lo < 30; lo += 2.5) {
+      std::vector<std::size_t> expected;
+      for (std::size_t i = 0; i < v.size(); ++i) {
+        auto score = get<"score">(v[i]);
+        if (lo <= score && score < lo + 4) expected.push_back(i);
+      }
+      auto found = v.range<"score">(lo, lo + 4);
+      EXPECT_TRUE(std::ranges::is_sorted(
+          found, {}, [&v](std::size_t i) { return get<"score">(v[i]); }));
+      std::ranges::sort(found);
+      EXPECT_EQ(found, expected);
+    }
+  };
+
+  for (int i = 0; i < 1000; ++i) {
+    v.emplace_back(tag<"name"> = std::to_string(i % 10), tag<"id"> = i % 37,
+                   tag<"score"> = (i * 7919 % 1000) / 40.0);
+  }
+  expect_consistent();
+  EXPECT_EQ(v.find<"name">("3").size(), 100);
+
+  for (int i = 0; i < 600; ++i) v.pop_back();
+  expect_consistent();
+
+  std::vector<Person> more;
+  for (int i = 0; i < 50; ++i) {
+    more.push_back(Person(tag<"id"> = i % 5, tag<"score"> = i * 0.5));
+  }
+  v.append(more);
+  expect_consistent();
+  v.append(std::views::iota(0, 3) | std::views::transform([](int i) {
+             return Person(tag<"name"> = std::string(20, 'x'), tag<"id"> = i);
+           }));
+  expect_consistent();
+  EXPECT_EQ(get<"name">(v.back()), std::string(20, 'x'));
+  std::vector<Person> copy(v.begin(), v.end());
+  v.append(copy);
+  EXPECT_EQ(v.size(), 906);
+  expect_consistent();
+
+  while (!v.empty()) v.pop_back();
+  EXPECT_TRUE(v.find<"id">(1).empty());
+  EXPECT_TRUE(v.range<"score">(0, 100).empty());
+  v.push_back(Person(tag<"id"> = 7, tag<"score"> = 1.0));
+  EXPECT_EQ(v.find<"id">(7), std::vector<std::size_t>{0});
+  EXPECT_EQ(v.find<"score">(1.0), std::vector<std::size_t>{0});
+  v.clear();
+  EXPECT_TRUE(v.find<"id">(7).empty());
+  EXPECT_EQ(get<"id">(v).size(), 0);
+}
+
+TEST(SoaVector, StringArenaStorage) {
+  using Resident =
+      tagged_tuple<member<"name", std::string>, member<"city", std::string>,
+                   member<"id", std::int64_t>>;
+  std::vector<Resident> residents;
+  for (int i = 0; i < 300; ++i) {
+    residents.push_back(Resident(
+        tag<"name"> = "a resident with a long name " + std::to_string(i),
+        tag<"city"> = "city " + std::to_string(i % 7), tag<"id"> = i));
+  }
+
+  auto check = [&residents](auto v) {
+    static_assert(std::is_same_v<decltype(get<"name">(v)[0]),
+                                 std::string_view>);
+    static_assert(
+        std::is_same_v<std::remove_cvref_t<decltype(get<"city">(v[0]))>,
+                       std::string_view>);
+    auto equals = [&v](const std::vector<Resident>& expected) {
+      return std::ranges::equal(v, expected, [](auto row, const auto& r) {
+        return get<"name">(row) == get<"name">(r) &&
+               get<"city">(row) == get<"city">(r) &&
+               get<"id">(row) == get<"id">(r);
+      });
+    };
+    std::vector<Resident> expected;
+
+    for (const auto& r : residents) v.push_back(r);
+    EXPECT_TRUE(equals(residents));
+    v.emplace_back(tag<"name"> = "x", tag<"city"> = "", tag<"id"> = 1);
+    EXPECT_EQ(get<"name">(v.back()), "x");
+    EXPECT_EQ(get<"city">(v.back()), "");
+    v.pop_back();
+    EXPECT_TRUE(equals(residents));
+
+    v.insert(v.begin() + 2, residents[9]);
+    v.insert(v.end(), residents[0]);
+    v.erase(v.begin() + 100, v.begin() + 150);
+    expected = residents;
+    expected.insert(expected.begin() + 2, residents[9]);
+    expected.insert(expected.end(), residents[0]);
+    expected.erase(expected.begin() + 100, expected.begin() + 150);
+    EXPECT_TRUE(equals(expected));
+
+    v.resize(10);
+    expected.resize(10);
+    v.resize(12, residents[5]);
+    expected.resize(12, residents[5]);
+    EXPECT_TRUE(equals(expected));
+    EXPECT_EQ(Resident(v[11]), residents[5]);
+
+    v.append(residents);
+    expected.insert(expected.end(), residents.begin(), residents.end());
+    EXPECT_TRUE(equals(expected));
+    auto copy = v;
+    EXPECT_TRUE(std::ranges::equal(get<"name">(copy), get<"name">(v)));
+    EXPECT_TRUE(std::ranges::equal(
+        std::vector<Resident>(v.begin(), v.end()), expected));
+
+    {
+      using namespace tag_relops;
+      auto predicate = tag<"city"> == std::string("city 3") && tag<"id"> > 50;
+      std::vector<std::size_t> selected;
+      for (std::size_t i = 0; i < expected.size(); ++i) {
+        if (predicate(expected[i])) selected.push_back(i);
+      }
+      EXPECT_EQ(filter(v, predicate), selected);
+      EXPECT_EQ(filter_bitmap(v, predicate).indices(), selected);
+      auto selected_rows = filter_copy(v, predicate);
+      EXPECT_EQ(selected_rows.size(), selected.size());
+      EXPECT_EQ(get<"city">(selected_rows.front()), "city 3");
+      EXPECT_EQ(filter(v, tag<"city"> != "city 3").size(),
+                expected.size() - filter(v, tag<"city"> == "city 3").size());
+      EXPECT_TRUE(filter(v, "nowhere" == tag<"city">).empty());
+      EXPECT_EQ(filter(v, tag<"city"> != "nowhere").size(), expected.size());
+    }
+
+    {
+      using namespace aggregates;
+      soa_vector<Resident> plain;
+      plain.append(expected);
+      auto groups =
+          group_by<"city">(v).aggregate(count, min<"name">, sum<"id">);
+      auto plain_groups =
+          group_by<"city">(plain).aggregate(count, min<"name">, sum<"id">);
+      EXPECT_EQ(groups.size(), 7);
+      EXPECT_TRUE(std::ranges::equal(
+          groups, plain_groups, [](auto row, const auto& plain_row) {
+            return get<"city">(row) == get<"city">(plain_row) &&
+                   get<"count">(row) == get<"count">(plain_row) &&
+                   get<"min_name">(row) == get<"min_name">(plain_row) &&
+                   get<"sum_id">(row) == get<"sum_id">(plain_row);
+          }));
+      EXPECT_EQ(group_by<"city">(v).parallel(3).aggregate(count).size(), 7);
+      EXPECT_EQ(group_by<"name">(v).aggregate(count).size(),
+                group_by<"name">(plain).aggregate(count).size());
+    }
+
+    auto moved = std::move(v);
+    EXPECT_EQ(moved.size(), expected.size());
+    v = {};
+    EXPECT_TRUE(v.empty());
+    v.push_back(residents[3]);
+    EXPECT_EQ(get<"name">(v[0]), get<"name">(residents[3]));
+    moved.clear();
+    EXPECT_TRUE(moved.empty());
+    EXPECT_TRUE(get<"name">(moved).empty());
+  };
+  check(soa_vector<Resident, string_arena_storage<>>());
+  check(soa_vector<Resident, string_arena_storage<"city">>());
+
+  soa_vector<Resident, string_arena_storage<"city">> v;
+  v.append(residents);
+  const auto& names = get<"name">(v).base();
+  EXPECT_EQ(names.offsets().size(), residents.size() + 1);
+  EXPECT_EQ(std::string_view(names.chars().data(), names.chars().size()),
+            std::accumulate(residents.begin(), residents.end(), std::string(),
+                            [](std::string s, const Resident& r) {
+                              return s + get<"name">(r);
+                            }));
+  const auto& cities = get<"city">(v).base();
+  EXPECT_EQ(cities.dictionary().size(), 7);
+  EXPECT_EQ(cities.codes().size(), residents.size());
+  EXPECT_EQ(cities.dictionary()[cities.code_of("city 4")], "city 4");
+  EXPECT_EQ(cities.code_of("city 7"), cities.no_code);
+}
+
 TEST(Json, BasicRoundTrip) {
   using Person =
       tagged_tuple<member<"name", std::string>, member<"address", std::string>,
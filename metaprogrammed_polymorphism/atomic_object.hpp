@@ -0,0 +1,225 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "polymorphic.hpp"
+
+namespace polymorphic {
+	namespace detail {
+
+		// A hazard pointer. A value is not deleted while a record points to it.
+		struct hazard_record {
+			std::atomic<const void*> pointer{ nullptr };
+			std::atomic<bool> active{ true };
+			hazard_record* next = nullptr;
+		};
+
+		// Records are reused, never freed, and shared by all atomic_objects.
+		class hazard_list {
+			std::atomic<hazard_record*> head_{ nullptr };
+
+		public:
+			hazard_record* acquire() {
+				for (auto r = head_.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+					bool expected = false;
+					if (!r->active.load(std::memory_order_relaxed) &&
+						r->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+						return r;
+					}
+				}
+				auto created = new hazard_record;
+				created->next = head_.load(std::memory_order_relaxed);
+				while (!head_.compare_exchange_weak(created->next, created,
+					std::memory_order_release, std::memory_order_relaxed)) {
+				}
+				return created;
+			}
+
+			void release(hazard_record* r) {
+				r->pointer.store(nullptr, std::memory_order_release);
+				r->active.store(false, std::memory_order_release);
+			}
+
+			// The values that are currently protected, sorted.
+			std::vector<const void*> protected_pointers() const {
+				std::vector<const void*> result;
+				for (auto r = head_.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+					if (auto p = r->pointer.load(std::memory_order_seq_cst)) result.push_back(p);
+				}
+				std::sort(result.begin(), result.end());
+				return result;
+			}
+		};
+
+		inline hazard_list& get_hazard_list() {
+			static hazard_list* list = new hazard_list;
+			return *list;
+		}
+
+		// Each thread keeps one record around, so a load in a loop does not have
+		// to search the list.
+		struct hazard_cache {
+			hazard_record* record = nullptr;
+			~hazard_cache() {
+				if (record) get_hazard_list().release(record);
+			}
+		};
+
+		inline hazard_cache& local_hazard_cache() {
+			thread_local hazard_cache cache;
+			return cache;
+		}
+
+		inline hazard_record* acquire_hazard() {
+			auto& cache = local_hazard_cache();
+			if (cache.record) return std::exchange(cache.record, nullptr);
+			return get_hazard_list().acquire();
+		}
+
+		inline void release_hazard(hazard_record* r) {
+			auto& cache = local_hazard_cache();
+			if (cache.record == nullptr) {
+				r->pointer.store(nullptr, std::memory_order_release);
+				cache.record = r;
+			}
+			else {
+				get_hazard_list().release(r);
+			}
+		}
+
+	} // namespace detail
+
+	// Holds an object<Signatures...> that readers can call while writers
+	// replace it, without locks on the read side. load() returns a handle which
+	// keeps the loaded value alive (with a hazard pointer) until it is
+	// destroyed, even if the value is replaced in the meantime. Writers swap in
+	// the new value with an atomic exchange, so concurrent stores do not wait
+	// for each other, and then retire the replaced value: under a mutex that
+	// only guards the retired list, they delete the retired values that no
+	// hazard pointer protects, and keep the others for a later retire or the
+	// destructor. All signatures must be const, as values are shared between
+	// threads.
+	//
+	// Handles must not outlive the atomic_object they were loaded from.
+	template <typename... Signatures>
+	class atomic_object {
+		static_assert(std::conjunction_v<detail::is_const_signature<Signatures>...>,
+			"atomic_object requires all signatures to be const.");
+
+	public:
+		using value_type = object<Signatures...>;
+
+		class handle {
+			friend class atomic_object;
+
+			detail::hazard_record* hazard_;
+			const value_type* value_;
+
+			handle(detail::hazard_record* hazard, const value_type* value)
+				:hazard_(hazard), value_(value) {}
+
+		public:
+			handle(handle&& other) noexcept
+				:hazard_(std::exchange(other.hazard_, nullptr)),
+				value_(std::exchange(other.value_, nullptr)) {}
+			handle& operator=(handle&& other) noexcept {
+				if (this != &other) {
+					reset();
+					hazard_ = std::exchange(other.hazard_, nullptr);
+					value_ = std::exchange(other.value_, nullptr);
+				}
+				return *this;
+			}
+			~handle() { reset(); }
+
+			void reset() {
+				if (hazard_) detail::release_hazard(hazard_);
+				hazard_ = nullptr;
+				value_ = nullptr;
+			}
+
+			explicit operator bool() const { return value_ != nullptr; }
+
+			// Valid while the handle is, as are refs made from it.
+			const value_type& get() const { return *value_; }
+
+			template <typename Method, typename... Parameters>
+			decltype(auto) call(Parameters&&... parameters) const {
+				return value_->template call<Method>(std::forward<Parameters>(parameters)...);
+			}
+		};
+
+		explicit atomic_object(value_type value) :value_(new value_type(std::move(value))) {}
+
+		atomic_object(const atomic_object&) = delete;
+		atomic_object& operator=(const atomic_object&) = delete;
+
+		~atomic_object() {
+			delete value_.load(std::memory_order_relaxed);
+			for (auto r : retired_) delete r;
+		}
+
+		handle load() const {
+			auto hazard = detail::acquire_hazard();
+			auto value = value_.load(std::memory_order_acquire);
+			for (;;) {
+				hazard->pointer.store(value, std::memory_order_seq_cst);
+				auto current = value_.load(std::memory_order_seq_cst);
+				if (current == value) break;
+				value = current;
+			}
+			return handle(hazard, value);
+		}
+
+		void store(value_type value) {
+			retire(value_.exchange(new value_type(std::move(value)), std::memory_order_seq_cst));
+		}
+
+		// Returns a copy of the replaced value, which shares it as all signatures
+		// are const.
+		value_type exchange(value_type value) {
+			auto old = value_.exchange(new value_type(std::move(value)), std::memory_order_seq_cst);
+			value_type result = *old;
+			retire(old);
+			return result;
+		}
+
+	private:
+		std::atomic<value_type*> value_;
+		std::mutex mutex_;
+		std::vector<value_type*> retired_;
+
+		void retire(value_type* old) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			retired_.push_back(old);
+			auto hazards = detail::get_hazard_list().protected_pointers();
+			auto in_use = std::remove_if(retired_.begin(), retired_.end(), [&](value_type* r) {
+				if (std::binary_search(hazards.begin(), hazards.end(), static_cast<const void*>(r))) {
+					return false;
+				}
+				delete r;
+				return true;
+				});
+			retired_.erase(in_use, retired_.end());
+		}
+	};
+
+} // namespace polymorphic
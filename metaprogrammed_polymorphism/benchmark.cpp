@@ -1,6 +1,21 @@
 #include "polymorphic.hpp"
+#include "atomic_object.hpp"
+#include "closed_object.hpp"
+#include "instrumentation.hpp"
+#include "poly_collection.hpp"
+#include <algorithm>
+#include <array>
 #include <benchmark/benchmark.h>
+#include <cstddef>
 #include <cstdlib>
+#include <deque>
+#include <memory_resource>
+#include <mutex>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
 
 #ifdef _MSC_VER
 #pragma comment(lib,"shlwapi.lib")
@@ -55,7 +70,77 @@ static void BM_PolyRef(benchmark::State& state) {
 		// This code gets timed
 		benchmark::DoNotOptimize(ref.call<draw>());
 	}
-	static_assert(sizeof(ref) == 3 * sizeof(void*));
+	static_assert(sizeof(ref) == 2 * sizeof(void*));
+}
+
+class size_of {};
+template <typename T>
+int poly_extend(size_of, const T&) { return sizeof(T); }
+
+using MultiObject = polymorphic::object<int(size_of) const, int(draw)>;
+
+// draw is not a prefix of MultiObject's signatures, so this goes through a
+// composite vtable.
+static void BM_PolySubsetRef(benchmark::State& state) {
+	MultiObject o(Dummy{});
+	polymorphic::ref<int(draw)> ref(o);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(ref.call<draw>());
+	}
+	static_assert(sizeof(ref) == 2 * sizeof(void*));
+}
+
+static void BM_PolySubsetRefVector(benchmark::State& state) {
+	std::vector<MultiObject> objects;
+	for (int i:GetRandVector()) {
+		if (i % 2) {
+			objects.emplace_back(Dummy{});
+		}
+		else {
+			objects.emplace_back(int{});
+		}
+	}
+	std::vector<polymorphic::ref<int(draw)>> refs(objects.begin(), objects.end());
+	for (auto _ : state) {
+		for (auto& r : refs) {
+			benchmark::DoNotOptimize(r.call<draw>());
+		}
+	}
+}
+
+static void BM_PolySubsetRefConversion(benchmark::State& state) {
+	MultiObject o(Dummy{});
+	for (auto _ : state) {
+		polymorphic::ref<int(draw)> ref(o);
+		benchmark::DoNotOptimize(ref);
+	}
+}
+
+static void BM_FunctionPointer(benchmark::State& state) {
+	Dummy d;
+	int (*f)(draw, Dummy&) = &poly_extend;
+	benchmark::DoNotOptimize(f);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(f(draw{}, d));
+	}
+}
+
+// Same as BM_PolyRef, but the compiler cannot see which function the ref holds.
+static void BM_PolyRefOpaque(benchmark::State& state) {
+	Dummy d;
+	polymorphic::ref<int(draw)> ref(d);
+	benchmark::DoNotOptimize(ref);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(ref.call<draw>());
+	}
+}
+
+static void BM_FunctionOpaque(benchmark::State& state) {
+	auto f = GetFunction();
+	benchmark::DoNotOptimize(f);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(f());
+	}
 }
 
 static void BM_PolyObject(benchmark::State& state) {
@@ -66,7 +151,7 @@ static void BM_PolyObject(benchmark::State& state) {
 		// This code gets timed
 		benchmark::DoNotOptimize(ref.call<draw>());
 	}
-	static_assert(sizeof(ref) == 4 * sizeof(void*));
+	static_assert(sizeof(ref) == 3 * sizeof(void*));
 }
 
 static void BM_PolyObjectVector(benchmark::State& state) {
@@ -144,18 +229,587 @@ static void BM_NonVirtualVector(benchmark::State& state) {
 		}
 	}
 }
+template <typename Object, typename T>
+static void BM_ObjectConstruct(benchmark::State& state) {
+	for (auto _ : state) {
+		Object o(T{});
+		benchmark::DoNotOptimize(o);
+	}
+}
+
+template <typename Object, typename T>
+static void BM_ObjectCopy(benchmark::State& state) {
+	Object o(T{});
+	for (auto _ : state) {
+		Object copy(o);
+		benchmark::DoNotOptimize(copy);
+	}
+}
+
+template <typename Object>
+static void BM_ObjectVectorCopyDestroy(benchmark::State& state) {
+	std::vector<Object> objects;
+	for (int i:GetRandVector()) {
+		if (i % 2) {
+			objects.emplace_back(Dummy{});
+		}
+		else {
+			objects.emplace_back(int{});
+		}
+	}
+	for (auto _ : state) {
+		auto copy = objects;
+		benchmark::DoNotOptimize(copy.data());
+	}
+}
+
+static void BM_PolyInlineObject(benchmark::State& state) {
+	Dummy d;
+	polymorphic::inline_object<int(draw)> ref(d);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(ref.call<draw>());
+	}
+	static_assert(sizeof(ref) == 8 * sizeof(void*));
+}
+
+// With instrumentation disabled the object is the same type as
+// polymorphic::object, so this measures the same code as an uninstrumented
+// vector.
+template <bool Enabled>
+static void BM_InstrumentedObjectVector(benchmark::State& state) {
+	using Object = polymorphic::basic_object<
+		polymorphic::instrumented<polymorphic::heap_storage, 64, Enabled>, int(draw)>;
+	static_assert(Enabled || std::is_same_v<Object, polymorphic::object<int(draw)>>);
+	std::vector<Object> objects;
+	for (int i : GetRandVector()) {
+		if (i % 2) {
+			objects.emplace_back(Dummy{});
+		}
+		else {
+			objects.emplace_back(int{});
+		}
+	}
+	for (auto _ : state) {
+		for (auto& o : objects) {
+			benchmark::DoNotOptimize(o.template call<draw>());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * objects.size());
+}
+
+template <typename Object>
+static void BM_ConstObjectVectorCopy(benchmark::State& state) {
+	std::vector<Object> objects;
+	for (int i = 0; i < 100000; ++i) {
+		if (i % 2) {
+			objects.emplace_back(Dummy{});
+		}
+		else {
+			objects.emplace_back(int{});
+		}
+	}
+	for (auto _ : state) {
+		auto copy = objects;
+		benchmark::DoNotOptimize(copy.data());
+	}
+	state.SetItemsProcessed(state.iterations() * objects.size());
+}
+
+// Readers call a strategy that thread 0 replaces every swap_interval calls.
+constexpr int swap_interval = 1024;
+
+using SwappedObject = polymorphic::object<int(size_of) const>;
+
+SwappedObject GetSwappedObject(int i) {
+	if (i % 2) return SwappedObject(Dummy{});
+	return SwappedObject(int{});
+}
+
+static void BM_AtomicObjectLoad(benchmark::State& state) {
+	static polymorphic::atomic_object<int(size_of) const> strategy(GetSwappedObject(0));
+	int i = 0;
+	for (auto _ : state) {
+		if (state.thread_index() == 0 && ++i % swap_interval == 0) {
+			strategy.store(GetSwappedObject(i / swap_interval));
+		}
+		benchmark::DoNotOptimize(strategy.load().call<size_of>());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_MutexObjectLoad(benchmark::State& state) {
+	static std::mutex mutex;
+	static SwappedObject strategy(GetSwappedObject(0));
+	int i = 0;
+	for (auto _ : state) {
+		if (state.thread_index() == 0 && ++i % swap_interval == 0) {
+			auto value = GetSwappedObject(i / swap_interval);
+			std::lock_guard<std::mutex> lock(mutex);
+			strategy = std::move(value);
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		benchmark::DoNotOptimize(strategy.call<size_of>());
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+// A table of 10k handlers, as built during startup by a router. With refs to
+// constexpr handlers the whole table is constant initialized, so startup does
+// no work at all.
+class route {};
+
+template <int N>
+struct Handler {
+	int id = N;
+};
+
+template <int N>
+int poly_extend(route, const Handler<N>& h) { return h.id; }
+
+constexpr int handler_types = 16;
+constexpr std::size_t handler_table_size = 10000;
+
+using HandlerRef = polymorphic::ref<int(route) const>;
+using HandlerObject = polymorphic::object<int(route) const>;
+
+template <int... N>
+constexpr std::tuple<Handler<N>...> MakeHandlers(std::integer_sequence<int, N...>) { return {}; }
+
+constexpr auto handlers = MakeHandlers(std::make_integer_sequence<int, handler_types>{});
+
+template <typename Table, std::size_t... I>
+constexpr Table MakeHandlerTable(std::index_sequence<I...>) {
+	return { { std::get<I % handler_types>(handlers)... } };
+}
+
+constexpr auto constant_handler_table = MakeHandlerTable<std::array<HandlerRef, handler_table_size>>(
+	std::make_index_sequence<handler_table_size>{});
+
+template <typename Object, int N>
+Object MakeHandler() { return Object(std::get<N>(handlers)); }
+
+template <typename Object, int... N>
+std::vector<Object> MakeHandlerVector(std::integer_sequence<int, N...>) {
+	static constexpr std::array<Object(*)(), sizeof...(N)> makers{ &MakeHandler<Object, N>... };
+	std::vector<Object> table;
+	table.reserve(handler_table_size);
+	for (std::size_t i = 0; i < handler_table_size; ++i) {
+		table.push_back(makers[i % handler_types]());
+	}
+	return table;
+}
+
+// Builds the table as a program would at startup, and routes one request.
+template <typename Object>
+static void BM_HandlerTableStartup(benchmark::State& state) {
+	for (auto _ : state) {
+		auto table = MakeHandlerVector<Object>(std::make_integer_sequence<int, handler_types>{});
+		benchmark::DoNotOptimize(table[handler_table_size / 2].template call<route>());
+	}
+}
+
+static void BM_ConstantHandlerTableStartup(benchmark::State& state) {
+	for (auto _ : state) {
+		auto& table = constant_handler_table;
+		benchmark::DoNotOptimize(table[handler_table_size / 2].call<route>());
+	}
+}
+
+constexpr int short_lived_size = 1000000;
+
+static void BM_ShortLivedObjects(benchmark::State& state) {
+	for (auto _ : state) {
+		int sum = 0;
+		for (int i = 0; i < short_lived_size; ++i) {
+			polymorphic::object<int(draw)> o = (i % 2) ?
+				polymorphic::object<int(draw)>(Dummy{}) : polymorphic::object<int(draw)>(int{});
+			sum += o.call<draw>();
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * short_lived_size);
+}
+
+static void BM_ShortLivedPmrObjects(benchmark::State& state) {
+	auto resource = std::pmr::new_delete_resource();
+	for (auto _ : state) {
+		int sum = 0;
+		for (int i = 0; i < short_lived_size; ++i) {
+			polymorphic::pmr::object<int(draw)> o = (i % 2) ?
+				polymorphic::pmr::object<int(draw)>(std::allocator_arg, resource, Dummy{}) :
+				polymorphic::pmr::object<int(draw)>(std::allocator_arg, resource, int{});
+			sum += o.call<draw>();
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * short_lived_size);
+}
+
+static void BM_ShortLivedArenaObjects(benchmark::State& state) {
+	std::vector<std::byte> buffer(short_lived_size * 2 * sizeof(int));
+	for (auto _ : state) {
+		std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+		int sum = 0;
+		for (int i = 0; i < short_lived_size; ++i) {
+			polymorphic::pmr::object<int(draw)> o = (i % 2) ?
+				polymorphic::pmr::object<int(draw)>(std::allocator_arg, &arena, Dummy{}) :
+				polymorphic::pmr::object<int(draw)>(std::allocator_arg, &arena, int{});
+			sum += o.call<draw>();
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * short_lived_size);
+}
+
+using ConstPolyObject = polymorphic::object<int(size_of) const>;
+using SharedPolyObject = polymorphic::shared_object<int(size_of) const>;
+using LocalSharedPolyObject = polymorphic::basic_object<
+	polymorphic::shared_storage<polymorphic::single_threaded>, int(size_of) const>;
+
+static void BM_PolyUniqueObject(benchmark::State& state) {
+	Dummy d;
+	polymorphic::unique_object<int(draw)> ref(d);
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(ref.call<draw>());
+	}
+	static_assert(sizeof(ref) == 2 * sizeof(void*));
+}
+
+using PolyObject = polymorphic::object<int(draw)>;
+using PolyInlineObject = polymorphic::inline_object<int(draw)>;
+using PolyUniqueObject = polymorphic::unique_object<int(draw)>;
+
+// Many concrete types sharing one method, for benchmarks where the call
+// pattern is hard to predict.
+class accumulate {};
+
+template <int N>
+struct Shape {
+	int value = N;
+};
+
+template <int N>
+void poly_extend(accumulate, const Shape<N>& s, int& sum) { sum += s.value; }
+
+class get_value {};
+
+template <int N>
+int poly_extend(get_value, const Shape<N>& s) { return s.value; }
+
+using AccumulateObject = polymorphic::object<void(accumulate, int&) const>;
+using AccumulateCollection = polymorphic::poly_collection<void(accumulate, int&) const>;
+
+constexpr int max_shape_types = 32;
+constexpr int shapes_size = 1000000;
+
+template <typename Object, int N>
+Object MakeShape() { return Object(Shape<N>{}); }
+
+template <int N>
+void InsertShape(AccumulateCollection& c) { c.insert(Shape<N>{}); }
+
+template <typename Object, int... N>
+Object MakeShape(int type, std::integer_sequence<int, N...>) {
+	static constexpr std::array<Object(*)(), sizeof...(N)> makers{ &MakeShape<Object, N>... };
+	return makers[type]();
+}
+
+template <int... N>
+void InsertShape(AccumulateCollection& c, int type, std::integer_sequence<int, N...>) {
+	static constexpr std::array<void(*)(AccumulateCollection&), sizeof...(N)> inserters{ &InsertShape<N>... };
+	inserters[type](c);
+}
+
+std::vector<int> GetRandTypes(int types) {
+	std::vector<int> vec;
+	for (int i = 0; i < shapes_size; ++i) {
+		vec.push_back(std::rand() % types);
+	}
+	return vec;
+}
+
+static void BM_AccumulateObjectVector(benchmark::State& state) {
+	std::vector<AccumulateObject> objects;
+	for (int type : GetRandTypes(static_cast<int>(state.range(0)))) {
+		objects.push_back(MakeShape<AccumulateObject>(type, std::make_integer_sequence<int, max_shape_types>{}));
+	}
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto& o : objects) {
+			o.call<accumulate>(sum);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * objects.size());
+}
+
+// The plain loop of BM_PolyObjectVector over 1M objects. Values allocated one
+// after another are laid out in order, which the hardware prefetcher handles
+// by itself, so the objects are shuffled to spread the values the loop visits
+// over the heap.
+template <typename Object = AccumulateObject>
+std::vector<Object> GetLargeObjectVector(bool shuffled) {
+	std::vector<Object> objects;
+	for (int type : GetRandTypes(8)) {
+		objects.push_back(MakeShape<Object>(type, std::make_integer_sequence<int, max_shape_types>{}));
+	}
+	if (shuffled) {
+		std::shuffle(objects.begin(), objects.end(), std::mt19937(42));
+	}
+	return objects;
+}
+
+static void BM_PolyObjectLargeVector(benchmark::State& state) {
+	auto objects = GetLargeObjectVector(state.range(0) != 0);
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto& o : objects) {
+			o.call<accumulate>(sum);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * objects.size());
+}
+
+template <std::size_t Distance>
+static void BM_PolyObjectLargeVectorCallAll(benchmark::State& state) {
+	auto objects = GetLargeObjectVector(state.range(0) != 0);
+	for (auto _ : state) {
+		int sum = 0;
+		polymorphic::call_all<accumulate, Distance>(objects, sum);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * objects.size());
+}
+
+template <std::size_t Distance>
+static void BM_PolyObjectLargeVectorCallAllInto(benchmark::State& state) {
+	auto objects = GetLargeObjectVector<polymorphic::object<int(get_value) const>>(
+		state.range(0) != 0);
+	std::vector<int> results(objects.size());
+	for (auto _ : state) {
+		polymorphic::call_all_into<get_value, Distance>(objects, results.begin());
+		benchmark::DoNotOptimize(results.data());
+	}
+	state.SetItemsProcessed(state.iterations() * objects.size());
+}
+
+static void BM_AccumulateRefVector(benchmark::State& state) {
+	std::vector<AccumulateObject> objects;
+	for (int type : GetRandTypes(static_cast<int>(state.range(0)))) {
+		objects.push_back(MakeShape<AccumulateObject>(type, std::make_integer_sequence<int, max_shape_types>{}));
+	}
+	std::vector<polymorphic::ref<void(accumulate, int&) const>> refs(objects.begin(), objects.end());
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto& r : refs) {
+			r.call<accumulate>(sum);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * refs.size());
+}
+
+static void BM_AccumulatePolyCollection(benchmark::State& state) {
+	AccumulateCollection collection;
+	for (int type : GetRandTypes(static_cast<int>(state.range(0)))) {
+		InsertShape(collection, type, std::make_integer_sequence<int, max_shape_types>{});
+	}
+	for (auto _ : state) {
+		int sum = 0;
+		collection.for_each_call<accumulate>(sum);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * collection.size());
+}
+
+template <typename Sequence> struct ShapeSet;
+
+template <int... N> struct ShapeSet<std::integer_sequence<int, N...>> {
+	using closed = polymorphic::closed_object<polymorphic::type_list<Shape<N>...>,
+		void(accumulate, int&) const>;
+	using variant = std::variant<Shape<N>...>;
+};
+
+template <int Types>
+static void BM_AccumulateClosedObjectVector(benchmark::State& state) {
+	using Sequence = std::make_integer_sequence<int, Types>;
+	using Closed = typename ShapeSet<Sequence>::closed;
+	std::vector<Closed> objects;
+	for (int type : GetRandTypes(Types)) {
+		objects.push_back(MakeShape<Closed>(type, Sequence{}));
+	}
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto& o : objects) {
+			o.template call<accumulate>(sum);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * objects.size());
+}
+
+template <int Types>
+static void BM_AccumulateVariantVector(benchmark::State& state) {
+	using Sequence = std::make_integer_sequence<int, Types>;
+	using Variant = typename ShapeSet<Sequence>::variant;
+	std::vector<Variant> objects;
+	for (int type : GetRandTypes(Types)) {
+		objects.push_back(MakeShape<Variant>(type, Sequence{}));
+	}
+	for (auto _ : state) {
+		int sum = 0;
+		for (auto& o : objects) {
+			std::visit([&](const auto& s) { poly_extend(accumulate{}, s, sum); }, o);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * objects.size());
+}
+
+// Double dispatch between two kinds of entity.
+class collide {};
+struct Asteroid {
+	int mass = 3;
+};
+struct Ship {
+	int shield = 5;
+};
+
+inline int poly_extend(collide, const Asteroid& a, const Asteroid& b) { return a.mass + b.mass; }
+inline int poly_extend(collide, const Asteroid& a, const Ship& s) { return a.mass - s.shield; }
+inline int poly_extend(collide, const Ship& s, const Asteroid& a) { return s.shield - a.mass; }
+inline int poly_extend(collide, const Ship& a, const Ship& b) { return a.shield * b.shield; }
+
+// The nested approach: the first call recovers the type of the first object,
+// and passes it to a method of the second object for each possible type.
+class collide_with {};
+class collide_asteroid {};
+class collide_ship {};
+struct Entity;
+using EntityBase = polymorphic::object<int(collide_with, const Entity&) const,
+	int(collide_asteroid, const Asteroid&) const, int(collide_ship, const Ship&) const>;
+struct Entity :EntityBase {
+	using EntityBase::EntityBase;
+};
+
+inline int poly_extend(collide_asteroid, const Asteroid& self, const Asteroid& a) { return poly_extend(collide{}, a, self); }
+inline int poly_extend(collide_asteroid, const Ship& self, const Asteroid& a) { return poly_extend(collide{}, a, self); }
+inline int poly_extend(collide_ship, const Asteroid& self, const Ship& s) { return poly_extend(collide{}, s, self); }
+inline int poly_extend(collide_ship, const Ship& self, const Ship& s) { return poly_extend(collide{}, s, self); }
+inline int poly_extend(collide_with, const Asteroid& a, const Entity& other) { return other.call<collide_asteroid>(a); }
+inline int poly_extend(collide_with, const Ship& s, const Entity& other) { return other.call<collide_ship>(s); }
+
+using ClosedEntity = polymorphic::closed_object<polymorphic::type_list<Asteroid, Ship>,
+	int(size_of) const>;
+
+constexpr int entities_size = 1000;
+
+static void BM_NestedCallDoubleDispatch(benchmark::State& state) {
+	// Entity's copy and move constructors would wrap the entity, so it is kept
+	// in a deque which never moves its elements.
+	std::deque<Entity> entities;
+	for (int i = 0; i < entities_size; ++i) {
+		if (std::rand() % 2) {
+			entities.emplace_back(Asteroid{});
+		}
+		else {
+			entities.emplace_back(Ship{});
+		}
+	}
+	for (auto _ : state) {
+		int sum = 0;
+		for (int i = 0; i < entities_size; ++i) {
+			sum += entities[i].call<collide_with>(entities[entities_size - 1 - i]);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * entities_size);
+}
+
+static void BM_Call2DoubleDispatch(benchmark::State& state) {
+	std::vector<ClosedEntity> entities;
+	for (int i = 0; i < entities_size; ++i) {
+		if (std::rand() % 2) {
+			entities.emplace_back(Asteroid{});
+		}
+		else {
+			entities.emplace_back(Ship{});
+		}
+	}
+	for (auto _ : state) {
+		int sum = 0;
+		for (int i = 0; i < entities_size; ++i) {
+			sum += polymorphic::call2<collide>(std::as_const(entities[i]),
+				std::as_const(entities[entities_size - 1 - i]));
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * entities_size);
+}
+
 // Register the function as a benchmark
 BENCHMARK(BM_NonVirtual);
 BENCHMARK(BM_Virtual);
 BENCHMARK(BM_Function);
 BENCHMARK(BM_PolyRef);
+BENCHMARK(BM_FunctionPointer);
+BENCHMARK(BM_PolyRefOpaque);
+BENCHMARK(BM_FunctionOpaque);
 BENCHMARK(BM_PolyObject);
+BENCHMARK(BM_PolySubsetRef);
+BENCHMARK(BM_PolySubsetRefConversion);
 
 BENCHMARK(BM_NonVirtualVector);
 BENCHMARK(BM_VirtualVector);
 BENCHMARK(BM_FunctionVector);
 BENCHMARK(BM_PolyRefVector);
 BENCHMARK(BM_PolyObjectVector);
+BENCHMARK(BM_PolySubsetRefVector);
+BENCHMARK(BM_PolyObjectLargeVector)->ArgName("shuffled")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_PolyObjectLargeVectorCallAll, 4)->ArgName("shuffled")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_PolyObjectLargeVectorCallAll, 16)->ArgName("shuffled")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_PolyObjectLargeVectorCallAll, 32)->ArgName("shuffled")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_PolyObjectLargeVectorCallAllInto, 16)->ArgName("shuffled")->Arg(0)->Arg(1);
+
+BENCHMARK_TEMPLATE(BM_InstrumentedObjectVector, false);
+BENCHMARK_TEMPLATE(BM_InstrumentedObjectVector, true);
+BENCHMARK(BM_PolyInlineObject);
+BENCHMARK(BM_PolyUniqueObject);
+BENCHMARK_TEMPLATE(BM_ObjectConstruct, PolyObject, int);
+BENCHMARK_TEMPLATE(BM_ObjectConstruct, PolyInlineObject, int);
+BENCHMARK_TEMPLATE(BM_ObjectConstruct, PolyObject, Dummy);
+BENCHMARK_TEMPLATE(BM_ObjectConstruct, PolyInlineObject, Dummy);
+BENCHMARK_TEMPLATE(BM_ObjectConstruct, PolyUniqueObject, int);
+BENCHMARK_TEMPLATE(BM_ObjectConstruct, PolyUniqueObject, Dummy);
+BENCHMARK_TEMPLATE(BM_ObjectCopy, PolyObject, int);
+BENCHMARK_TEMPLATE(BM_ObjectCopy, PolyInlineObject, int);
+BENCHMARK_TEMPLATE(BM_ObjectCopy, PolyObject, Dummy);
+BENCHMARK_TEMPLATE(BM_ObjectCopy, PolyInlineObject, Dummy);
+BENCHMARK_TEMPLATE(BM_ObjectVectorCopyDestroy, PolyObject);
+BENCHMARK_TEMPLATE(BM_ObjectVectorCopyDestroy, PolyInlineObject);
+BENCHMARK_TEMPLATE(BM_ConstObjectVectorCopy, ConstPolyObject);
+BENCHMARK_TEMPLATE(BM_ConstObjectVectorCopy, SharedPolyObject);
+BENCHMARK_TEMPLATE(BM_ConstObjectVectorCopy, LocalSharedPolyObject);
+BENCHMARK(BM_AtomicObjectLoad)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_MutexObjectLoad)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HandlerTableStartup, HandlerObject);
+BENCHMARK_TEMPLATE(BM_HandlerTableStartup, HandlerRef);
+BENCHMARK(BM_ConstantHandlerTableStartup);
+BENCHMARK(BM_ShortLivedObjects);
+BENCHMARK(BM_ShortLivedPmrObjects);
+BENCHMARK(BM_ShortLivedArenaObjects);
+
+BENCHMARK(BM_AccumulateObjectVector)->Arg(2)->Arg(8)->Arg(max_shape_types);
+BENCHMARK(BM_AccumulateRefVector)->Arg(2)->Arg(8)->Arg(max_shape_types);
+BENCHMARK(BM_AccumulatePolyCollection)->Arg(2)->Arg(8)->Arg(max_shape_types);
+BENCHMARK_TEMPLATE(BM_AccumulateClosedObjectVector, 2);
+BENCHMARK_TEMPLATE(BM_AccumulateClosedObjectVector, 8);
+BENCHMARK_TEMPLATE(BM_AccumulateVariantVector, 2);
+BENCHMARK_TEMPLATE(BM_AccumulateVariantVector, 8);
+
+BENCHMARK(BM_NestedCallDoubleDispatch);
+BENCHMARK(BM_Call2DoubleDispatch);
 
 
 BENCHMARK_MAIN();
@@ -0,0 +1,291 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "polymorphic.hpp"
+
+namespace polymorphic {
+	template <typename... Ts> struct type_list {};
+
+	namespace detail {
+
+		template <typename Signature> struct signature_getter;
+
+		template <typename Method, typename Return, typename... Parameters>
+		struct signature_getter<Return(Method, Parameters...)> {
+			type<Return(Method, Parameters...)> operator()(Method) const { return {}; }
+		};
+
+		template <typename Method, typename Return, typename... Parameters>
+		struct signature_getter<Return(Method, Parameters...) const> {
+			type<Return(Method, Parameters...) const> operator()(Method) const { return {}; }
+		};
+
+		template <typename T, typename... Ts>
+		constexpr std::size_t type_index() {
+			constexpr bool matches[] = { std::is_same_v<T, Ts>... };
+			for (std::size_t i = 0; i < sizeof...(Ts); ++i) {
+				if (matches[i]) return i;
+			}
+			return sizeof...(Ts);
+		}
+
+		template <typename TypeList, typename... Signatures>
+		class closed_object_impl;
+
+		// Holds exactly one of Ts inline, identified by index_. Calls go through an
+		// if/else chain on index_ that the compiler lowers to a jump table, and
+		// each case is a direct, inlinable call to the trampoline used by object.
+		template <typename... Ts, typename... Signatures>
+		class closed_object_impl<type_list<Ts...>, Signatures...> {
+			static_assert(sizeof...(Ts) > 0 && sizeof...(Ts) <= 255);
+			// Moves construct into buffer_ in place, so a throwing move would leave
+			// no value to destroy.
+			static_assert((std::is_nothrow_move_constructible_v<Ts> && ...),
+				"Types in the closed set must be nothrow move constructible.");
+
+			alignas(Ts...) unsigned char buffer_[std::max({ sizeof(Ts)... })];
+			std::uint8_t index_;
+
+			static constexpr overload<signature_getter<Signatures>...> get_signature{};
+
+			template <std::size_t I, typename T, typename... Rest, typename F>
+			static decltype(auto) visit(std::size_t index, void* t, F& f) {
+				if constexpr (sizeof...(Rest) == 0) {
+					return f(static_cast<T*>(t));
+				}
+				else {
+					if (index == I) return f(static_cast<T*>(t));
+					return visit<I + 1, Rest...>(index, t, f);
+				}
+			}
+
+			template <std::size_t I, typename T, typename... Rest, typename F>
+			static decltype(auto) visit(std::size_t index, const void* t, F& f) {
+				if constexpr (sizeof...(Rest) == 0) {
+					return f(static_cast<const T*>(t));
+				}
+				else {
+					if (index == I) return f(static_cast<const T*>(t));
+					return visit<I + 1, Rest...>(index, t, f);
+				}
+			}
+
+			template <typename F>
+			decltype(auto) visit(F&& f) { return visit<0, Ts...>(index_, get_ptr(), f); }
+
+			template <typename F>
+			decltype(auto) visit(F&& f) const { return visit<0, Ts...>(index_, get_ptr(), f); }
+
+			template <typename Return, typename Method, typename... Parameters, typename... Args>
+			Return call_impl(type<Return(Method, Parameters...)>, Args&&... args) {
+				return visit([&](auto* t) -> Return {
+					using T = std::remove_pointer_t<decltype(t)>;
+					return trampoline<T, Return(Method, Parameters...)>::jump(
+						t, std::forward<Args>(args)...);
+					});
+			}
+
+			template <typename Return, typename Method, typename... Parameters, typename... Args>
+			Return call_impl(type<Return(Method, Parameters...) const>, Args&&... args) const {
+				return visit([&](const auto* t) -> Return {
+					using T = std::remove_const_t<std::remove_pointer_t<decltype(t)>>;
+					return trampoline<T, Return(Method, Parameters...) const>::jump(
+						t, std::forward<Args>(args)...);
+					});
+			}
+
+			void destroy() {
+				visit([](auto* t) {
+					using T = std::remove_pointer_t<decltype(t)>;
+					t->~T();
+					});
+			}
+
+		public:
+			using types = type_list<Ts...>;
+
+			template <typename T, typename = std::enable_if_t<
+				(type_index<std::decay_t<T>, Ts...>() < sizeof...(Ts))>>
+			closed_object_impl(T&& t) :index_(type_index<std::decay_t<T>, Ts...>()) {
+				::new (static_cast<void*>(buffer_)) std::decay_t<T>(std::forward<T>(t));
+			}
+
+			closed_object_impl(const closed_object_impl& other) :index_(other.index_) {
+				other.visit([&](const auto* t) {
+					using T = std::remove_const_t<std::remove_pointer_t<decltype(t)>>;
+					::new (static_cast<void*>(buffer_)) T(*t);
+					});
+			}
+
+			closed_object_impl(closed_object_impl&& other) noexcept :index_(other.index_) {
+				other.visit([&](auto* t) {
+					using T = std::remove_pointer_t<decltype(t)>;
+					::new (static_cast<void*>(buffer_)) T(std::move(*t));
+					});
+			}
+
+			closed_object_impl& operator=(const closed_object_impl& other) {
+				return (*this) = closed_object_impl(other);
+			}
+
+			closed_object_impl& operator=(closed_object_impl&& other) noexcept {
+				if (this != &other) {
+					destroy();
+					index_ = other.index_;
+					other.visit([&](auto* t) {
+						using T = std::remove_pointer_t<decltype(t)>;
+						::new (static_cast<void*>(buffer_)) T(std::move(*t));
+						});
+				}
+				return *this;
+			}
+
+			~closed_object_impl() { destroy(); }
+
+			std::size_t index() const { return index_; }
+
+			void* get_ptr() { return buffer_; }
+			const void* get_ptr() const { return buffer_; }
+
+			template <typename Method, typename... Parameters>
+			decltype(auto) call(Parameters&&... parameters) const {
+				return call_impl(get_signature(Method{}), std::forward<Parameters>(parameters)...);
+			}
+
+			template <typename Method, typename... Parameters>
+			decltype(auto) call(Parameters&&... parameters) {
+				return call_impl(get_signature(Method{}), std::forward<Parameters>(parameters)...);
+			}
+		};
+
+		// Double dispatch support for call2.
+
+		struct no_result {};
+
+		template <typename Void, typename Method, typename A, typename B, typename... Args>
+		struct pair_result {
+			static constexpr bool viable = false;
+			using type = no_result;
+		};
+
+		template <typename Method, typename A, typename B, typename... Args>
+		struct pair_result<std::void_t<decltype(poly_extend(Method{}, std::declval<A&>(),
+			std::declval<B&>(), std::declval<Args>()...))>, Method, A, B, Args...> {
+			static constexpr bool viable = true;
+			using type = decltype(poly_extend(Method{}, std::declval<A&>(),
+				std::declval<B&>(), std::declval<Args>()...));
+		};
+
+		// The common type of all viable results, or void if there are none. Results
+		// of one type, such as references, are kept as they are.
+		template <typename R1, typename R2> struct combine_result {
+			using type = std::common_type_t<R1, R2>;
+		};
+		template <typename R> struct combine_result<R, R> { using type = R; };
+		template <typename R> struct combine_result<no_result, R> { using type = R; };
+		template <typename R> struct combine_result<R, no_result> { using type = R; };
+		template <> struct combine_result<no_result, no_result> { using type = no_result; };
+
+		template <typename Result, typename... Rs> struct common_result {
+			using type = std::conditional_t<std::is_same_v<Result, no_result>, void, Result>;
+		};
+		template <typename Result, typename R, typename... Rs>
+		struct common_result<Result, R, Rs...>
+			: common_result<typename combine_result<Result, R>::type, Rs...> {};
+
+		template <typename... Lists> struct concat { using type = type_list<>; };
+		template <typename... Ts> struct concat<type_list<Ts...>> { using type = type_list<Ts...>; };
+		template <typename... Ts, typename... Us, typename... Rest>
+		struct concat<type_list<Ts...>, type_list<Us...>, Rest...>
+			: concat<type_list<Ts..., Us...>, Rest...> {};
+
+		template <typename List> struct result_of_list;
+		template <typename... Rs> struct result_of_list<type_list<Rs...>>
+			: common_result<no_result, Rs...> {};
+
+		template <typename Object, typename List> struct qualified_types;
+		template <typename Object, typename... Ts>
+		struct qualified_types<Object, type_list<Ts...>> {
+			using type = type_list<std::conditional_t<std::is_const_v<Object>, const Ts, Ts>...>;
+		};
+
+		template <typename Object>
+		using qualified_types_t = typename qualified_types<Object,
+			typename std::remove_const_t<Object>::types>::type;
+
+		template <typename Method, typename TypesA, typename TypesB, typename... Args>
+		struct double_dispatch;
+
+		// table[i][j] calls poly_extend(Method, As[i]&, Bs[j]&, args...). Every pair
+		// must have a viable overload.
+		template <typename Method, typename... As, typename... Bs, typename... Args>
+		struct double_dispatch<Method, type_list<As...>, type_list<Bs...>, Args...> {
+			template <typename A>
+			using row_results = type_list<typename pair_result<void, Method, A, Bs, Args...>::type...>;
+
+			using result_type = typename result_of_list<
+				typename concat<row_results<As>...>::type>::type;
+
+			using pointer_a = std::conditional_t<(std::is_const_v<As> && ...), const void*, void*>;
+			using pointer_b = std::conditional_t<(std::is_const_v<Bs> && ...), const void*, void*>;
+			using entry = ptr<result_type(pointer_a, pointer_b, Args&&...)>;
+
+			template <typename A, typename B>
+			static result_type jump(pointer_a a, pointer_b b, Args&&... args) {
+				constexpr bool viable = pair_result<void, Method, A, B, Args...>::viable;
+				static_assert(viable, "call2 needs a poly_extend overload for every pair of "
+					"types; declare a template overload to handle the others");
+				if constexpr (viable) {
+					return poly_extend(Method{}, *static_cast<A*>(a), *static_cast<B*>(b),
+						std::forward<Args>(args)...);
+				}
+			}
+
+			template <typename A>
+			static constexpr std::array<entry, sizeof...(Bs)> row() {
+				return { &jump<A, Bs>... };
+			}
+
+			static constexpr std::array<std::array<entry, sizeof...(Bs)>, sizeof...(As)> table{
+				row<As>()... };
+		};
+
+	} // namespace detail
+
+	template <typename TypeList, typename... Signatures>
+	using closed_object = detail::closed_object_impl<TypeList, Signatures...>;
+
+	// Calls poly_extend(Method{}, A&, B&, args...) where A and B are the types
+	// held by two closed objects, through a table indexed by both types. Every
+	// pair of types must have a viable overload, which fails to compile
+	// otherwise; declare a template overload of poly_extend as a fallback for
+	// the pairs that need no specific one.
+	template <typename Method, typename ObjectA, typename ObjectB, typename... Args>
+	decltype(auto) call2(ObjectA& a, ObjectB& b, Args&&... args) {
+		using dispatch = detail::double_dispatch<Method, detail::qualified_types_t<ObjectA>,
+			detail::qualified_types_t<ObjectB>, Args...>;
+		return dispatch::table[a.index()][b.index()](a.get_ptr(), b.get_ptr(),
+			std::forward<Args>(args)...);
+	}
+
+} // namespace polymorphic
@@ -0,0 +1,317 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// limitations under the License.
+
+// Dispatch benchmarks at sizes where the working set leaves the caches and
+// the branch predictor cannot learn the call pattern.
+//
+// Every benchmark takes the arguments objects/types/shuffled/cold:
+//   objects   number of objects, 1K to 10M
+//   types     number of concrete types, 2 to 64
+//   shuffled  0 if objects are grouped by type, 1 if the types are random
+//   cold      1 if the caches are flushed before every iteration
+//
+// Besides time, each benchmark reports ns_per_call (nanoseconds per
+// dispatched call), and on Linux cycles_per_call and llc_misses_per_call
+// from perf_event_open (these are left out when perf events are not
+// permitted, e.g. with kernel.perf_event_paranoid > 2). To track regressions, run with
+//   --benchmark_format=json --benchmark_out=dispatch.json
+// and use --benchmark_filter to pick a subset, as the full suite is large.
+
+#include "polymorphic.hpp"
+#include <algorithm>
+#include <array>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+#pragma comment(lib,"shlwapi.lib")
+#endif
+
+namespace {
+
+#ifdef __linux__
+class perf_counter {
+	int fd_ = -1;
+public:
+	perf_counter(std::uint32_t type, std::uint64_t config) {
+		perf_event_attr attr{};
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+	perf_counter(const perf_counter&) = delete;
+	perf_counter& operator=(const perf_counter&) = delete;
+	~perf_counter() {
+		if (valid()) close(fd_);
+	}
+	bool valid() const { return fd_ >= 0; }
+	void start() {
+		if (valid()) ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	void stop() {
+		if (valid()) ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+	}
+	std::uint64_t value() const {
+		std::uint64_t v = 0;
+		if (valid() && read(fd_, &v, sizeof(v)) != sizeof(v)) v = 0;
+		return v;
+	}
+};
+
+perf_counter MakeCyclesCounter() {
+	return perf_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+}
+perf_counter MakeLlcMissesCounter() {
+	return perf_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+}
+#else
+struct perf_counter {
+	bool valid() const { return false; }
+	void start() {}
+	void stop() {}
+	std::uint64_t value() const { return 0; }
+};
+perf_counter MakeCyclesCounter() { return {}; }
+perf_counter MakeLlcMissesCounter() { return {}; }
+#endif
+
+// Larger than the last level cache of current machines.
+void FlushCaches() {
+	static std::vector<unsigned char> buffer(64 * 1024 * 1024);
+	for (std::size_t i = 0; i < buffer.size(); i += 64) {
+		++buffer[i];
+	}
+	benchmark::DoNotOptimize(buffer.data());
+	benchmark::ClobberMemory();
+}
+
+constexpr int max_types = 64;
+
+class draw {};
+
+template <int N>
+struct Shape {
+	int value = N;
+};
+
+template <int N>
+int poly_extend(draw, const Shape<N>& s) { return s.value; }
+
+struct Base {
+	virtual int draw() const = 0;
+	virtual ~Base() {}
+};
+
+template <int N>
+struct Derived :Base {
+	int value = N;
+	int draw() const override { return value; }
+};
+
+// Calls make<N>() for a runtime N < max_types.
+template <typename Maker, int... N>
+auto MakeType(int type, std::integer_sequence<int, N...>) {
+	using result = decltype(Maker::template make<0>());
+	static constexpr std::array<result(*)(), sizeof...(N)> makers{ &Maker::template make<N>... };
+	return makers[type]();
+}
+
+template <typename Maker>
+auto MakeType(int type) {
+	return MakeType<Maker>(type, std::make_integer_sequence<int, max_types>{});
+}
+
+struct VirtualSuite {
+	template <int N>
+	static std::unique_ptr<Base> make() { return std::make_unique<Derived<N>>(); }
+
+	std::vector<std::unique_ptr<Base>> objects;
+	void add(int type) { objects.push_back(MakeType<VirtualSuite>(type)); }
+	int run() const {
+		int sum = 0;
+		for (auto& o : objects) sum += o->draw();
+		return sum;
+	}
+};
+
+struct FunctionSuite {
+	template <int N>
+	static std::function<int()> make() {
+		return [s = Shape<N>{}]() { return s.value; };
+	}
+
+	std::vector<std::function<int()>> objects;
+	void add(int type) { objects.push_back(MakeType<FunctionSuite>(type)); }
+	int run() const {
+		int sum = 0;
+		for (auto& o : objects) sum += o();
+		return sum;
+	}
+};
+
+template <typename Sequence> struct shape_variant;
+template <int... N> struct shape_variant<std::integer_sequence<int, N...>> {
+	using type = std::variant<Shape<N>...>;
+};
+using ShapeVariant = shape_variant<std::make_integer_sequence<int, max_types>>::type;
+
+struct VariantSuite {
+	template <int N>
+	static ShapeVariant make() { return Shape<N>{}; }
+
+	std::vector<ShapeVariant> objects;
+	void add(int type) { objects.push_back(MakeType<VariantSuite>(type)); }
+	int run() const {
+		int sum = 0;
+		for (auto& o : objects) {
+			sum += std::visit([](const auto& s) { return poly_extend(draw{}, s); }, o);
+		}
+		return sum;
+	}
+};
+
+using DrawObject = polymorphic::object<int(draw) const>;
+
+struct ObjectSuite {
+	template <int N>
+	static DrawObject make() { return DrawObject(Shape<N>{}); }
+
+	std::vector<DrawObject> objects;
+	void add(int type) { objects.push_back(MakeType<ObjectSuite>(type)); }
+	int run() const {
+		int sum = 0;
+		for (auto& o : objects) sum += o.call<draw>();
+		return sum;
+	}
+};
+
+struct RefSuite {
+	ObjectSuite storage;
+	std::vector<polymorphic::ref<int(draw) const>> refs;
+	void add(int type) { storage.add(type); }
+	int run() {
+		if (refs.size() != storage.objects.size()) {
+			refs.assign(storage.objects.begin(), storage.objects.end());
+		}
+		int sum = 0;
+		for (auto& r : refs) sum += r.call<draw>();
+		return sum;
+	}
+};
+
+std::vector<int> GetTypes(std::int64_t objects, int types, bool shuffled) {
+	std::vector<int> result;
+	result.reserve(objects);
+	for (std::int64_t i = 0; i < objects; ++i) {
+		result.push_back(static_cast<int>(i * types / objects));
+	}
+	if (shuffled) {
+		std::mt19937 generator(42);
+		std::shuffle(result.begin(), result.end(), generator);
+	}
+	return result;
+}
+
+template <typename Suite>
+void BM_Dispatch(benchmark::State& state) {
+	const auto objects = state.range(0);
+	const bool cold = state.range(3) != 0;
+	Suite suite;
+	for (int type : GetTypes(objects, static_cast<int>(state.range(1)), state.range(2) != 0)) {
+		suite.add(type);
+	}
+	// Builds anything lazily initialized outside of the timed region.
+	benchmark::DoNotOptimize(suite.run());
+
+	auto cycles = MakeCyclesCounter();
+	auto llc_misses = MakeLlcMissesCounter();
+	std::chrono::steady_clock::duration elapsed{};
+	for (auto _ : state) {
+		if (cold) {
+			state.PauseTiming();
+			FlushCaches();
+			state.ResumeTiming();
+		}
+		cycles.start();
+		llc_misses.start();
+		const auto start = std::chrono::steady_clock::now();
+		benchmark::DoNotOptimize(suite.run());
+		elapsed += std::chrono::steady_clock::now() - start;
+		cycles.stop();
+		llc_misses.stop();
+	}
+
+	const double calls = static_cast<double>(state.iterations()) * objects;
+	state.counters["ns_per_call"] = std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+	if (cycles.valid()) {
+		state.counters["cycles_per_call"] = cycles.value() / calls;
+	}
+	if (llc_misses.valid()) {
+		state.counters["llc_misses_per_call"] = llc_misses.value() / calls;
+	}
+	state.SetItemsProcessed(static_cast<std::int64_t>(calls));
+}
+
+void Arguments(benchmark::internal::Benchmark* b, bool cold) {
+	b->ArgNames({ "objects", "types", "shuffled", "cold" });
+	for (std::int64_t objects = 1000; objects <= 10000000; objects *= 10) {
+		for (int types : { 2, 8, 64 }) {
+			for (int shuffled : { 0, 1 }) {
+				b->Args({ objects, types, shuffled, cold ? 1 : 0 });
+			}
+		}
+	}
+}
+
+void WarmArguments(benchmark::internal::Benchmark* b) { Arguments(b, false); }
+
+// Flushing takes far longer than the timed region for small sizes, so cold
+// runs use a fixed number of iterations.
+void ColdArguments(benchmark::internal::Benchmark* b) {
+	Arguments(b, true);
+	b->Iterations(20);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Dispatch, VirtualSuite)->Apply(WarmArguments);
+BENCHMARK_TEMPLATE(BM_Dispatch, FunctionSuite)->Apply(WarmArguments);
+BENCHMARK_TEMPLATE(BM_Dispatch, VariantSuite)->Apply(WarmArguments);
+BENCHMARK_TEMPLATE(BM_Dispatch, RefSuite)->Apply(WarmArguments);
+BENCHMARK_TEMPLATE(BM_Dispatch, ObjectSuite)->Apply(WarmArguments);
+
+BENCHMARK_TEMPLATE(BM_Dispatch, VirtualSuite)->Apply(ColdArguments);
+BENCHMARK_TEMPLATE(BM_Dispatch, FunctionSuite)->Apply(ColdArguments);
+BENCHMARK_TEMPLATE(BM_Dispatch, VariantSuite)->Apply(ColdArguments);
+BENCHMARK_TEMPLATE(BM_Dispatch, RefSuite)->Apply(ColdArguments);
+BENCHMARK_TEMPLATE(BM_Dispatch, ObjectSuite)->Apply(ColdArguments);
+
+BENCHMARK_MAIN();
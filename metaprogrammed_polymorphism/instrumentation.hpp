@@ -0,0 +1,323 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+#include "polymorphic.hpp"
+
+// Instrumented objects count every call per (Method, concrete type), and time
+// one call in SamplePeriod. Instrumentation is opt in with the instrumented
+// storage policy:
+//
+//   using shape = polymorphic::basic_object<
+//       polymorphic::instrumented<polymorphic::heap_storage>, int(draw) const>;
+//
+// and refs made from an instrumented object keep counting, as they share its
+// vtable. When disabled, either with Enabled or for the whole program by
+// defining POLYMORPHIC_NO_INSTRUMENTATION, instrumented<Storage> is Storage,
+// so it compiles to exactly the uninstrumented code.
+
+namespace polymorphic {
+
+#ifdef POLYMORPHIC_NO_INSTRUMENTATION
+	inline constexpr bool instrumentation_enabled = false;
+#else
+	inline constexpr bool instrumentation_enabled = true;
+#endif
+
+	template <typename Storage, std::uint32_t SamplePeriod>
+	struct instrumented_storage {};
+
+	template <typename Storage, std::uint32_t SamplePeriod = 64,
+		bool Enabled = instrumentation_enabled>
+	using instrumented = std::conditional_t<Enabled,
+		instrumented_storage<Storage, SamplePeriod>, Storage>;
+
+	// Calls of one Method on one concrete type, summed over all threads.
+	struct call_stats {
+		std::string method;
+		std::string type;
+		std::uint64_t calls = 0;
+		std::uint64_t sampled_calls = 0;
+		std::uint64_t sampled_nanoseconds = 0;
+
+		double mean_nanoseconds() const {
+			return sampled_calls == 0 ? 0.0
+				: static_cast<double>(sampled_nanoseconds) / sampled_calls;
+		}
+	};
+
+	namespace detail {
+
+		struct call_site {
+			const std::type_info& method;
+			const std::type_info& type;
+		};
+
+		// Only the owning thread writes to a block, so increments are a relaxed
+		// load and store instead of a read-modify-write. Blocks outlive their
+		// thread so that its calls are still reported, and are then handed to the
+		// next thread that calls the same site, so there are only as many blocks
+		// per site as threads that called it at the same time.
+		struct call_counters {
+			const call_site* site;
+			std::atomic<std::uint64_t> calls{ 0 };
+			std::atomic<std::uint64_t> sampled_calls{ 0 };
+			std::atomic<std::uint64_t> sampled_nanoseconds{ 0 };
+			call_counters* next;
+			// Whether a thread owns the block, guarded by the registry mutex.
+			bool owned;
+
+			static void add(std::atomic<std::uint64_t>& counter, std::uint64_t value) {
+				counter.store(counter.load(std::memory_order_relaxed) + value,
+					std::memory_order_relaxed);
+			}
+		};
+
+		class call_registry {
+			std::mutex mutex_;
+			call_counters* head_ = nullptr;
+
+		public:
+			// A block for site that no thread owns, added if there is none. The
+			// mutex orders the counts of the previous owner before the new one.
+			call_counters* acquire(const call_site* site) {
+				std::lock_guard<std::mutex> lock(mutex_);
+				for (auto c = head_; c != nullptr; c = c->next) {
+					if (c->site == site && !c->owned) {
+						c->owned = true;
+						return c;
+					}
+				}
+				head_ = new call_counters{ site, {}, {}, {}, head_, true };
+				return head_;
+			}
+
+			void release(call_counters* counters) {
+				std::lock_guard<std::mutex> lock(mutex_);
+				counters->owned = false;
+			}
+
+			template <typename F>
+			void for_each(F f) {
+				std::lock_guard<std::mutex> lock(mutex_);
+				for (auto c = head_; c != nullptr; c = c->next) f(*c);
+			}
+		};
+
+		// Never destroyed, so threads that exit during static destruction can
+		// still use it.
+		inline call_registry& get_call_registry() {
+			static call_registry* registry = new call_registry;
+			return *registry;
+		}
+
+		// The block of a thread for a site, released when the thread exits.
+		class counters_owner {
+			call_counters* counters_;
+		public:
+			explicit counters_owner(const call_site* site)
+				:counters_(get_call_registry().acquire(site)) {}
+			counters_owner(const counters_owner&) = delete;
+			counters_owner& operator=(const counters_owner&) = delete;
+			~counters_owner() { get_call_registry().release(counters_); }
+
+			call_counters& get() const { return *counters_; }
+		};
+
+		template <typename T, typename Method>
+		struct call_site_for {
+			static inline const call_site site{ typeid(Method), typeid(T) };
+
+			static call_counters& counters() {
+				thread_local counters_owner owner(&site);
+				return owner.get();
+			}
+		};
+
+		class sample_timer {
+			call_counters* counters_;
+			std::chrono::steady_clock::time_point start_;
+		public:
+			explicit sample_timer(call_counters* counters) :counters_(counters) {
+				if (counters_) start_ = std::chrono::steady_clock::now();
+			}
+			sample_timer(const sample_timer&) = delete;
+			sample_timer& operator=(const sample_timer&) = delete;
+			~sample_timer() {
+				if (!counters_) return;
+				auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start_).count();
+				call_counters::add(counters_->sampled_calls, 1);
+				call_counters::add(counters_->sampled_nanoseconds,
+					static_cast<std::uint64_t>(elapsed));
+			}
+		};
+
+		template <std::uint32_t SamplePeriod>
+		call_counters* count_call(call_counters& counters) {
+			auto calls = counters.calls.load(std::memory_order_relaxed);
+			counters.calls.store(calls + 1, std::memory_order_relaxed);
+			return calls % SamplePeriod == 0 ? &counters : nullptr;
+		}
+
+		template <typename T, typename Signature, std::uint32_t SamplePeriod>
+		struct instrumented_trampoline;
+
+		template <typename T, typename Return, typename Method, typename... Parameters,
+			std::uint32_t SamplePeriod>
+		struct instrumented_trampoline<T, Return(Method, Parameters...), SamplePeriod> {
+			static auto jump(void* t, Parameters... parameters) -> Return {
+				sample_timer timer(count_call<SamplePeriod>(
+					call_site_for<T, Method>::counters()));
+				return trampoline<T, Return(Method, Parameters...)>::jump(
+					t, fwd<Parameters>(parameters)...);
+			}
+		};
+
+		template <typename T, typename Return, typename Method, typename... Parameters,
+			std::uint32_t SamplePeriod>
+		struct instrumented_trampoline<T, Return(Method, Parameters...) const, SamplePeriod> {
+			static auto jump(const void* t, Parameters... parameters) -> Return {
+				sample_timer timer(count_call<SamplePeriod>(
+					call_site_for<T, Method>::counters()));
+				return trampoline<T, Return(Method, Parameters...) const>::jump(
+					t, fwd<Parameters>(parameters)...);
+			}
+		};
+
+		template <typename T, std::uint32_t SamplePeriod> struct instrumented_type {};
+
+		// Same layout as vtable, so conversions to refs with fewer or reordered
+		// signatures keep the instrumented functions.
+		template <typename T, std::uint32_t SamplePeriod, typename... Signatures>
+		inline const vtable_fun instrumented_vtable[] = {
+			reinterpret_cast<vtable_fun>(composite_vtables<
+				instrumented_type<T, SamplePeriod>, Signatures...>::resolve),
+			reinterpret_cast<vtable_fun>(
+				instrumented_trampoline<T, Signatures, SamplePeriod>::jump)... };
+
+		// A Holder that marks its ref_impl as instrumented, and is otherwise the
+		// same as Holder.
+		template <typename Holder, std::uint32_t SamplePeriod>
+		struct instrumented_holder :Holder {
+			using Holder::Holder;
+		};
+
+		// An instrumented ref made from an uninstrumented object or ref would
+		// keep its vtable, and count nothing.
+		template <typename Holder, std::uint32_t SamplePeriod, typename OtherHolder>
+		struct holder_converts_from<instrumented_holder<Holder, SamplePeriod>, OtherHolder>
+			:std::false_type {};
+
+		template <typename Holder, std::uint32_t SamplePeriod, typename OtherHolder,
+			std::uint32_t OtherSamplePeriod>
+		struct holder_converts_from<instrumented_holder<Holder, SamplePeriod>,
+			instrumented_holder<OtherHolder, OtherSamplePeriod>> :std::true_type {};
+
+		template <typename Holder, std::uint32_t SamplePeriod, typename T,
+			typename... Signatures>
+		struct vtable_for<instrumented_holder<Holder, SamplePeriod>, T, Signatures...> {
+			static constexpr const vtable_fun* get() {
+				return &instrumented_vtable<T, SamplePeriod, Signatures...>[0];
+			}
+
+			template <typename Signature>
+			static constexpr auto function() {
+				return &instrumented_trampoline<T, Signature, SamplePeriod>::jump;
+			}
+		};
+
+		template <typename Storage, std::uint32_t SamplePeriod, bool IsConst>
+		struct storage_holder<instrumented_storage<Storage, SamplePeriod>, IsConst> {
+			using type = instrumented_holder<
+				typename storage_holder<Storage, IsConst>::type, SamplePeriod>;
+		};
+
+		inline std::string demangle(const char* name) {
+#if __has_include(<cxxabi.h>)
+			int status = 0;
+			char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+			if (status == 0 && demangled) {
+				std::string result(demangled);
+				std::free(demangled);
+				return result;
+			}
+#endif
+			return name;
+		}
+
+	} // namespace detail
+
+	// A ref that counts the calls made through it. It converts from instrumented
+	// objects and refs, but not from uninstrumented ones, whose calls it could
+	// not count.
+	template <typename... Signatures>
+	using instrumented_ref = std::conditional_t<instrumentation_enabled,
+		detail::ref_impl<detail::instrumented_holder<detail::ptr_holder<std::conditional_t<
+		std::conjunction_v<detail::is_const_signature<Signatures>...>,
+		const void, void>>, 64>,
+		std::make_index_sequence<sizeof...(Signatures)>, Signatures...>,
+		ref<Signatures...>>;
+
+	// Sums the counters of all threads, including threads that have exited.
+	// Counts from threads that are still calling may be slightly behind.
+	inline std::vector<call_stats> instrumentation_snapshot() {
+		std::map<std::pair<const std::type_info*, const std::type_info*>, call_stats> sums;
+		detail::get_call_registry().for_each([&](const detail::call_counters& c) {
+			auto& stats = sums[{ &c.site->method, &c.site->type }];
+			stats.calls += c.calls.load(std::memory_order_relaxed);
+			stats.sampled_calls += c.sampled_calls.load(std::memory_order_relaxed);
+			stats.sampled_nanoseconds += c.sampled_nanoseconds.load(std::memory_order_relaxed);
+			if (stats.method.empty()) {
+				stats.method = detail::demangle(c.site->method.name());
+				stats.type = detail::demangle(c.site->type.name());
+			}
+			});
+		std::vector<call_stats> result;
+		for (auto& entry : sums) result.push_back(std::move(entry.second));
+		std::sort(result.begin(), result.end(), [](const call_stats& a, const call_stats& b) {
+			return a.calls > b.calls;
+			});
+		return result;
+	}
+
+	// Writes one line per (Method, type), most called first.
+	inline void dump_instrumentation(std::ostream& os) {
+		for (auto& stats : instrumentation_snapshot()) {
+			os << stats.method << " " << stats.type << " calls=" << stats.calls
+				<< " sampled=" << stats.sampled_calls
+				<< " mean_ns=" << stats.mean_nanoseconds() << "\n";
+		}
+	}
+
+} // namespace polymorphic
@@ -0,0 +1,182 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "polymorphic.hpp"
+
+namespace polymorphic {
+	namespace detail {
+
+		// A segment trampoline runs the whole loop for one concrete type, so the
+		// only indirect call is the one per segment.
+		template <typename T, typename Signature> struct segment_trampoline;
+
+		template <typename T, typename Return, typename Method, typename... Parameters>
+		struct segment_trampoline<T, Return(Method, Parameters...)> {
+			static void jump(void* values, Parameters&... parameters) {
+				for (auto& t : *static_cast<std::vector<T>*>(values)) {
+					poly_extend(Method{}, t, parameters...);
+				}
+			}
+		};
+
+		template <typename T, typename Return, typename Method, typename... Parameters>
+		struct segment_trampoline<T, Return(Method, Parameters...) const> {
+			static void jump(const void* values, Parameters&... parameters) {
+				for (const auto& t : *static_cast<const std::vector<T>*>(values)) {
+					poly_extend(Method{}, t, parameters...);
+				}
+			}
+		};
+
+		template <typename T, typename... Signatures>
+		inline const vtable_fun segment_vtable[] = {
+			reinterpret_cast<vtable_fun>(segment_trampoline<T, Signatures>::jump)... };
+
+		template <std::size_t I, typename Signature> struct segment_caller;
+
+		template <std::size_t I, typename Method, typename Return, typename... Parameters>
+		struct segment_caller<I, Return(Method, Parameters...)> {
+			void operator()(const vtable_fun* vt, Method, void* values,
+				Parameters... parameters) const {
+				reinterpret_cast<ptr<void(void*, Parameters&...)>>(vt[I])(values, parameters...);
+			}
+		};
+
+		template <std::size_t I, typename Method, typename Return, typename... Parameters>
+		struct segment_caller<I, Return(Method, Parameters...) const> {
+			void operator()(const vtable_fun* vt, Method, const void* values,
+				Parameters... parameters) const {
+				reinterpret_cast<ptr<void(const void*, Parameters&...)>>(vt[I])(values, parameters...);
+			}
+		};
+
+		struct segment_interface {
+			virtual std::unique_ptr<segment_interface> clone() const = 0;
+			virtual std::size_t size() const = 0;
+			virtual void clear() = 0;
+			virtual ~segment_interface() {}
+			const vtable_fun* loops_ = nullptr;
+			void* values_ = nullptr;
+		};
+
+		template <typename T, typename... Signatures>
+		struct segment_impl :segment_interface {
+			segment_impl() { init(); }
+			segment_impl(const segment_impl& other) :t_(other.t_) { init(); }
+			void init() {
+				loops_ = &segment_vtable<T, Signatures...>[0];
+				values_ = &t_;
+			}
+			std::unique_ptr<segment_interface> clone() const override {
+				return std::make_unique<segment_impl>(*this);
+			}
+			std::size_t size() const override { return t_.size(); }
+			void clear() override { t_.clear(); }
+			std::vector<T> t_;
+		};
+
+		template <typename Sequence, typename... Signatures>
+		class poly_collection_impl;
+
+		// Stores values grouped by concrete type, one contiguous std::vector per
+		// type. Segments are keyed by the type's vtable, the same one an object
+		// holding that type would point to.
+		template <std::size_t... I, typename... Signatures>
+		class poly_collection_impl<std::index_sequence<I...>, Signatures...> {
+			std::vector<std::unique_ptr<segment_interface>> segments_;
+			std::unordered_map<const vtable_fun*, std::size_t> index_;
+
+			static constexpr overload<segment_caller<I, Signatures>...> call_segment{};
+
+			template <typename T>
+			std::vector<T>& segment() {
+				const vtable_fun* key = &vtable<T, Signatures...>[0];
+				auto iter = index_.find(key);
+				if (iter == index_.end()) {
+					iter = index_.emplace(key, segments_.size()).first;
+					segments_.push_back(std::make_unique<segment_impl<T, Signatures...>>());
+				}
+				return static_cast<segment_impl<T, Signatures...>&>(*segments_[iter->second]).t_;
+			}
+
+		public:
+			poly_collection_impl() = default;
+			poly_collection_impl(poly_collection_impl&&) = default;
+			poly_collection_impl& operator=(poly_collection_impl&&) = default;
+			poly_collection_impl(const poly_collection_impl& other) :index_(other.index_) {
+				for (auto& s : other.segments_) segments_.push_back(s->clone());
+			}
+			poly_collection_impl& operator=(const poly_collection_impl& other) {
+				return (*this) = poly_collection_impl(other);
+			}
+
+			template <typename T>
+			void insert(T t) { segment<T>().push_back(std::move(t)); }
+
+			template <typename T, typename... Args>
+			T& emplace(Args&&... args) {
+				return segment<T>().emplace_back(std::forward<Args>(args)...);
+			}
+
+			template <typename T>
+			void reserve(std::size_t n) { segment<T>().reserve(n); }
+
+			std::size_t size() const {
+				std::size_t result = 0;
+				for (auto& s : segments_) result += s->size();
+				return result;
+			}
+			bool empty() const { return size() == 0; }
+			std::size_t segment_count() const { return segments_.size(); }
+
+			// Keeps the segments (and their capacity) around.
+			void clear() {
+				for (auto& s : segments_) s->clear();
+			}
+
+			// Calls Method on every element, one segment at a time. Elements of a
+			// segment are visited in insertion order, but there is no ordering
+			// between segments. Arguments are converted to the parameter types of
+			// the signature, as by call, once per segment, and passed to every call
+			// as lvalues. Return values are discarded.
+			template <typename Method, typename... Parameters>
+			void for_each_call(Parameters&&... parameters) {
+				for (auto& s : segments_) {
+					call_segment(s->loops_, Method{}, s->values_, parameters...);
+				}
+			}
+
+			template <typename Method, typename... Parameters>
+			void for_each_call(Parameters&&... parameters) const {
+				for (auto& s : segments_) {
+					call_segment(s->loops_, Method{}, static_cast<const void*>(s->values_),
+						parameters...);
+				}
+			}
+		};
+
+	} // namespace detail
+
+	template <typename... Signatures>
+	using poly_collection = detail::poly_collection_impl<
+		std::make_index_sequence<sizeof...(Signatures)>, Signatures...>;
+
+} // namespace polymorphic
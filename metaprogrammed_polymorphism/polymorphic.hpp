@@ -13,11 +13,23 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
 
 namespace polymorphic {
 	namespace detail {
@@ -36,6 +48,16 @@ namespace polymorphic {
 		template <typename T> struct type {};
 		template <typename... F> struct overload : F... { using F::operator()...; };
 
+		inline void prefetch(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+			__builtin_prefetch(p);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+			(void)p;
+#endif
+		}
+
 		template <typename T, typename Signature> struct trampoline;
 
 		template <typename T, typename Return, typename Method, typename... Parameters>
@@ -56,26 +78,122 @@ namespace polymorphic {
 
 		using vtable_fun = ptr<void()>;
 
+		// Entry 0 of every vtable resolves the vtable for a reordering or subset of
+		// its signatures. permutation[i] is the index (in the source) of the
+		// signature that goes in slot i of the result.
+		using vtable_resolver = ptr<const vtable_fun* (const vtable_fun* source,
+			const std::uint8_t* permutation, std::size_t size)>;
+
+		struct composite_vtable {
+			const vtable_fun* source;
+			std::vector<std::uint8_t> permutation;
+			std::vector<vtable_fun> functions;
+			const composite_vtable* next;
+		};
+
+		// Composite vtables are built on first use and then live for the rest of
+		// the program, like the static ones. They are kept in a lock free, insert
+		// only list per concrete type and signature set, which is shared by the
+		// vtables derived from it (they all copy entry 0).
+		template <typename T, typename... Signatures>
+		struct composite_vtables {
+			static inline std::atomic<const composite_vtable*> head{ nullptr };
+
+			static const vtable_fun* resolve(const vtable_fun* source,
+				const std::uint8_t* permutation, std::size_t size) {
+				auto matches = [&](const composite_vtable* c) {
+					return c->source == source && std::equal(c->permutation.begin(),
+						c->permutation.end(), permutation, permutation + size);
+				};
+				auto expected = head.load(std::memory_order_acquire);
+				for (auto c = expected; c != nullptr; c = c->next) {
+					if (matches(c)) return c->functions.data();
+				}
+
+				auto created = new composite_vtable{ source,
+					{ permutation, permutation + size }, { source[0] }, expected };
+				for (std::size_t i = 0; i < size; ++i) {
+					created->functions.push_back(source[permutation[i] + 1]);
+				}
+				while (!head.compare_exchange_weak(expected, created,
+					std::memory_order_release, std::memory_order_acquire)) {
+					// Another thread may have just added the same vtable.
+					for (auto c = expected; c != created->next; c = c->next) {
+						if (matches(c)) {
+							delete created;
+							return c->functions.data();
+						}
+					}
+					created->next = expected;
+				}
+				return created->functions.data();
+			}
+		};
+
 		template <typename T, typename... Signatures>
 		inline const vtable_fun vtable[] = {
+			reinterpret_cast<vtable_fun>(composite_vtables<T, Signatures...>::resolve),
 			reinterpret_cast<vtable_fun>(trampoline<T, Signatures>::jump)... };
 
+		template <typename Signature> struct trampoline_type;
+
+		template <typename Return, typename Method, typename... Parameters>
+		struct trampoline_type<Return(Method, Parameters...)> {
+			using type = ptr<Return(void*, Parameters...)>;
+		};
+
+		template <typename Return, typename Method, typename... Parameters>
+		struct trampoline_type<Return(Method, Parameters...) const> {
+			using type = ptr<Return(const void*, Parameters...)>;
+		};
+
+		// How a ref_impl finds its functions. With several signatures it points to
+		// a vtable. With a single signature it stores the trampoline itself, like a
+		// function_ref, which saves a load per call. Both can be constructed in a
+		// constant expression from a VtableFor (see vtable_for below).
+		template <typename... Signatures>
+		class vtable_ptr {
+			const vtable_fun* vptr_;
+		public:
+			template <typename VtableFor>
+			constexpr explicit vtable_ptr(type<VtableFor>) : vptr_(VtableFor::get()) {}
+			constexpr explicit vtable_ptr(const vtable_fun* vt) : vptr_(vt) {}
+			constexpr const vtable_fun* get() const { return vptr_; }
+			vtable_fun function(std::size_t i) const { return vptr_[i + 1]; }
+			void prefetch() const { detail::prefetch(vptr_); }
+		};
+
+		template <typename Signature>
+		class vtable_ptr<Signature> {
+			using function_type = typename trampoline_type<Signature>::type;
+			function_type function_;
+		public:
+			template <typename VtableFor>
+			constexpr explicit vtable_ptr(type<VtableFor>)
+				: function_(VtableFor::template function<Signature>()) {}
+			explicit vtable_ptr(vtable_fun f) : function_(reinterpret_cast<function_type>(f)) {}
+			vtable_fun function(std::size_t) const { return reinterpret_cast<vtable_fun>(function_); }
+			void prefetch() const {}
+		};
+
 		template <size_t I, typename Signature> struct vtable_caller;
 
 		template <size_t I, typename Method, typename Return, typename... Parameters>
 		struct vtable_caller<I, Return(Method, Parameters...)> {
-			decltype(auto) operator()(const vtable_fun* vt, const std::uint8_t* permutation, Method, void* t,
+			template <typename... Signatures>
+			decltype(auto) operator()(const vtable_ptr<Signatures...>& vt, Method, void* t,
 				Parameters... parameters) const {
-				return reinterpret_cast<ptr<Return(void*, Parameters...)>>(vt[permutation[I]])(
+				return reinterpret_cast<ptr<Return(void*, Parameters...)>>(vt.function(I))(
 					t, fwd<Parameters>(parameters)...);
 			}
 		};
 
 		template <std::size_t I, typename Method, typename Return, typename... Parameters>
 		struct vtable_caller<I, Return(Method, Parameters...) const> {
-			decltype(auto) operator()(const vtable_fun* vt, const std::uint8_t* permutation, Method, const void* t,
+			template <typename... Signatures>
+			decltype(auto) operator()(const vtable_ptr<Signatures...>& vt, Method, const void* t,
 				Parameters... parameters) const {
-				return reinterpret_cast<ptr<Return(const void*, Parameters...)>>(vt[permutation[I]])(t, fwd<Parameters>(parameters)...);
+				return reinterpret_cast<ptr<Return(const void*, Parameters...)>>(vt.function(I))(t, fwd<Parameters>(parameters)...);
 			}
 		};
 
@@ -91,6 +209,17 @@ namespace polymorphic {
 
 		struct value_tag {};
 
+		// The vtable that a ref_impl using Holder points to for a T, and the
+		// trampoline for Signature. Holders can specialize this to call through
+		// different trampolines.
+		template <typename Holder, typename T, typename... Signatures>
+		struct vtable_for {
+			static constexpr const vtable_fun* get() { return &vtable<T, Signatures...>[0]; }
+
+			template <typename Signature>
+			static constexpr auto function() { return &trampoline<T, Signature>::jump; }
+		};
+
 		template <typename Holder, typename Sequence, typename... Signatures>
 		class ref_impl;
 
@@ -100,48 +229,100 @@ namespace polymorphic {
 		template <typename Holder, typename Sequence, typename... Signatures>
 		struct is_ref_impl<ref_impl<Holder, Sequence, Signatures...>> :std::true_type {};
 
+		// Whether a ref_impl with Holder can be converted from one with
+		// OtherHolder, taking over its vtable. Holders that need vtables of their
+		// own, like the instrumented ones, specialize it.
+		template <typename Holder, typename OtherHolder>
+		struct holder_converts_from :std::true_type {};
+
 		template <typename Holder, size_t... I, typename... Signatures>
 		class ref_impl<Holder, std::index_sequence<I...>, Signatures...> { 
 
 			template <typename OtherHolder, typename OtherSequence, typename... OtherSignatures>
 			friend class ref_impl;
 
-			const detail::vtable_fun* vptr_;
-			std::array<std::uint8_t, sizeof...(Signatures)> permutation_;
+			vtable_ptr<Signatures...> vptr_;
 			Holder t_;
 
 			static constexpr overload<vtable_caller<I, Signatures>...> call_vtable{};
 			static constexpr overload<index_getter<I, Signatures>...> get_index{};
 
+			// With the same signatures the functions of OtherRef can be used as
+			// they are. A single signature only needs the function from OtherRef. The
+			// vtable of OtherRef can be used as is if our signatures are a prefix of
+			// its signatures. Otherwise we need a composite vtable.
+			template <typename OtherRef>
+			static constexpr vtable_ptr<Signatures...> convert_vtable(const OtherRef& other) {
+				if constexpr (std::is_same_v<decltype(other.vptr_), vtable_ptr<Signatures...>>) {
+					return other.vptr_;
+				}
+				else if constexpr (sizeof...(Signatures) == 1) {
+					return vtable_ptr<Signatures...>(
+						other.vptr_.function(OtherRef::get_index(type<Signatures>{})...));
+				}
+				else {
+					const vtable_fun* vt = other.vptr_.get();
+					constexpr std::array<std::uint8_t, sizeof...(Signatures)> permutation{
+						static_cast<std::uint8_t>(OtherRef::get_index(type<Signatures>{}))... };
+					if constexpr (((permutation[I] == I) && ...)) {
+						return vtable_ptr<Signatures...>(vt);
+					}
+					else {
+						return vtable_ptr<Signatures...>(reinterpret_cast<vtable_resolver>(vt[0])(
+							vt, permutation.data(), permutation.size()));
+					}
+				}
+			}
+
 			template <typename T>
-			ref_impl(T&& t, std::false_type)
-				: vptr_(&detail::vtable<std::decay_t<T>, Signatures...>[0]), permutation_{ I... },
+			constexpr ref_impl(T&& t, std::false_type)
+				: vptr_(type<vtable_for<Holder, std::decay_t<T>, Signatures...>>{}),
 				t_(std::forward<T>(t), value_tag{}) {}
 
 			template <typename OtherRef>
-			ref_impl(OtherRef&& other, std::true_type)
-				: vptr_(other.vptr_), permutation_{ other.permutation_[other.get_index(type<Signatures>{})]... },
+			constexpr ref_impl(OtherRef&& other, std::true_type)
+				: vptr_(convert_vtable(other)),
 				t_(std::forward<OtherRef>(other).t_) {
+				static_assert(holder_converts_from<Holder, decltype(other.t_)>::value,
+					"The vtable of other cannot be used with this holder.");
 			}
 
 		public:
+			// A ref to a value with static storage duration, or to another ref with
+			// the same signatures, is a constant expression, so tables of refs can be
+			// constant initialized. The vtables of objects are constants too, but an
+			// owning object cannot be constexpr: it constructs its value in heap
+			// memory or in a byte buffer, and constant evaluation can neither keep
+			// an allocation nor construct a type erased value in raw bytes.
 			template <typename T>
-			ref_impl(T&& t) :ref_impl(std::forward<T>(t), is_ref_impl<std::decay_t<T>>{}) {}
+			constexpr ref_impl(T&& t) :ref_impl(std::forward<T>(t), is_ref_impl<std::decay_t<T>>{}) {}
+
+			// Only for holders that take an allocator.
+			template <typename Allocator, typename T>
+			ref_impl(std::allocator_arg_t, const Allocator& allocator, T&& t)
+				: vptr_(type<vtable_for<Holder, std::decay_t<T>, Signatures...>>{}),
+				t_(std::forward<T>(t), allocator, value_tag{}) {}
 
 			explicit operator bool() const { return t_ != nullptr; }
 
 			auto get_ptr() const { return t_.get_ptr(); }
 			auto get_ptr() { return t_.get_ptr(); }
 
+			// Starts loading what a call will need, the value and the vtable.
+			void prefetch() const {
+				detail::prefetch(t_.get_ptr());
+				vptr_.prefetch();
+			}
+
 			template <typename Method, typename... Parameters>
 			decltype(auto) call(Parameters&&... parameters) const {
-				return call_vtable(vptr_, permutation_.data(), Method{}, t_.get_ptr(),
+				return call_vtable(vptr_, Method{}, t_.get_ptr(),
 					std::forward<Parameters>(parameters)...);
 			}
 
 			template <typename Method, typename... Parameters>
 			decltype(auto) call(Parameters&&... parameters) {
-				return call_vtable(vptr_, permutation_.data(), Method{}, t_.get_ptr(),
+				return call_vtable(vptr_, Method{}, t_.get_ptr(),
 					std::forward<Parameters>(parameters)...);
 			}
 		};
@@ -210,15 +391,382 @@ namespace polymorphic {
 			auto clone_ptr()const { return impl_ ? impl_->clone() : nullptr; }
 		};
 
+		// Type erased copy/relocate/destroy for inline_holder. copy and relocate
+		// construct into the supplied buffer (or the heap) and return the address
+		// of the new object. relocate also destroys the source.
+		struct storage_ops {
+			ptr<void* (const void*, void*)> copy;
+			ptr<void* (void*, void*)> relocate;
+			ptr<void(void*)> destroy;
+		};
+
+		template<typename T>
+		struct inline_ops {
+			static void* copy(const void* from, void* buffer) {
+				return ::new (buffer) T(*static_cast<const T*>(from));
+			}
+			static void* relocate(void* from, void* buffer) {
+				T* t = static_cast<T*>(from);
+				void* result = ::new (buffer) T(std::move(*t));
+				t->~T();
+				return result;
+			}
+			static void destroy(void* t) { static_cast<T*>(t)->~T(); }
+		};
+
+		template<typename T>
+		struct heap_ops {
+			static void* copy(const void* from, void*) {
+				return new T(*static_cast<const T*>(from));
+			}
+			static void* relocate(void* from, void*) { return from; }
+			static void destroy(void* t) { delete static_cast<T*>(t); }
+		};
+
+		template<typename Ops>
+		inline constexpr storage_ops storage_ops_for{ &Ops::copy, &Ops::relocate, &Ops::destroy };
+
+		// Stores small, nothrow movable types in an inline buffer, and everything
+		// else on the heap. ptr_ always points at the stored object so calls do not
+		// need to know where it lives.
+		template<std::size_t Size, std::size_t Align>
+		class inline_holder {
+			const storage_ops* ops_ = nullptr;
+			void* ptr_ = nullptr;
+			alignas(Align) unsigned char buffer_[Size];
+
+			template<typename T>
+			static constexpr bool fits = sizeof(T) <= Size && Align % alignof(T) == 0 &&
+				std::is_nothrow_move_constructible_v<T>;
+
+			void steal(inline_holder& other) noexcept {
+				ops_ = other.ops_;
+				ptr_ = ops_ ? ops_->relocate(other.ptr_, buffer_) : nullptr;
+				other.ops_ = nullptr;
+				other.ptr_ = nullptr;
+			}
+
+		public:
+			template<typename T>
+			inline_holder(T t, value_tag) {
+				if constexpr (fits<T>) {
+					ptr_ = ::new (static_cast<void*>(buffer_)) T(std::move(t));
+					ops_ = &storage_ops_for<inline_ops<T>>;
+				}
+				else {
+					ptr_ = new T(std::move(t));
+					ops_ = &storage_ops_for<heap_ops<T>>;
+				}
+			}
+
+			inline_holder(const inline_holder& other) :ops_(other.ops_),
+				ptr_(other.ops_ ? other.ops_->copy(other.ptr_, buffer_) : nullptr) {}
+			inline_holder& operator=(const inline_holder& other) {
+				return (*this) = inline_holder(other);
+			}
+
+			inline_holder(inline_holder&& other)noexcept { steal(other); }
+			inline_holder& operator=(inline_holder&& other)noexcept {
+				if (this != &other) {
+					reset();
+					steal(other);
+				}
+				return *this;
+			}
+
+			~inline_holder() { reset(); }
+
+			void reset() {
+				if (ops_) ops_->destroy(ptr_);
+				ops_ = nullptr;
+				ptr_ = nullptr;
+			}
+
+			void* get_ptr() { return ptr_; }
+			const void* get_ptr()const { return ptr_; }
+		};
+
+		// Type erased operations for allocator_holder. Values are allocated and
+		// constructed through std::allocator_traits, so uses-allocator
+		// construction applies (e.g. std::pmr::string gets the memory resource).
+		template<typename Allocator>
+		struct allocator_ops {
+			ptr<void* (const void*, Allocator&)> copy;
+			ptr<void* (void*, Allocator&)> move;
+			ptr<void(void*, Allocator&)> destroy;
+		};
+
+		template<typename T, typename Allocator>
+		struct allocator_ops_impl {
+			using traits = typename std::allocator_traits<Allocator>::template rebind_traits<T>;
+			using allocator_type = typename traits::allocator_type;
+
+			template<typename... Args>
+			static T* create(Allocator& allocator, Args&&... args) {
+				allocator_type a(allocator);
+				T* t = traits::allocate(a, 1);
+				try {
+					traits::construct(a, t, std::forward<Args>(args)...);
+				}
+				catch (...) {
+					traits::deallocate(a, t, 1);
+					throw;
+				}
+				return t;
+			}
+			static void* copy(const void* from, Allocator& allocator) {
+				return create(allocator, *static_cast<const T*>(from));
+			}
+			static void* move(void* from, Allocator& allocator) {
+				return create(allocator, std::move(*static_cast<T*>(from)));
+			}
+			static void destroy(void* t, Allocator& allocator) {
+				allocator_type a(allocator);
+				traits::destroy(a, static_cast<T*>(t));
+				traits::deallocate(a, static_cast<T*>(t), 1);
+			}
+		};
+
+		template<typename T, typename Allocator>
+		inline constexpr allocator_ops<Allocator> allocator_ops_for{
+			&allocator_ops_impl<T, Allocator>::copy, &allocator_ops_impl<T, Allocator>::move,
+			&allocator_ops_impl<T, Allocator>::destroy };
+
+		// Allocates the value with an allocator. Like the standard containers, the
+		// allocator stays with the holder on assignment; moving from a holder with
+		// an unequal allocator moves the value into a new allocation.
+		template<typename Allocator>
+		class allocator_holder {
+			const allocator_ops<Allocator>* ops_ = nullptr;
+			void* ptr_ = nullptr;
+			Allocator allocator_;
+
+		public:
+			using allocator_type = Allocator;
+
+			template<typename T>
+			allocator_holder(T t, value_tag) :allocator_holder(std::move(t), Allocator(), value_tag{}) {}
+
+			template<typename T>
+			allocator_holder(T t, const Allocator& allocator, value_tag) :ops_(&allocator_ops_for<T, Allocator>),
+				ptr_(nullptr), allocator_(allocator) {
+				ptr_ = allocator_ops_impl<T, Allocator>::create(allocator_, std::move(t));
+			}
+
+			allocator_holder(const allocator_holder& other) :ops_(other.ops_),
+				allocator_(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.allocator_)) {
+				ptr_ = ops_ ? ops_->copy(other.ptr_, allocator_) : nullptr;
+			}
+			allocator_holder& operator=(const allocator_holder& other) {
+				if (this != &other) {
+					void* p = other.ops_ ? other.ops_->copy(other.ptr_, allocator_) : nullptr;
+					reset();
+					ops_ = other.ops_;
+					ptr_ = p;
+				}
+				return *this;
+			}
+
+			allocator_holder(allocator_holder&& other)noexcept :ops_(std::exchange(other.ops_, nullptr)),
+				ptr_(std::exchange(other.ptr_, nullptr)), allocator_(other.allocator_) {}
+			allocator_holder& operator=(allocator_holder&& other) {
+				if (this == &other) return *this;
+				if (allocator_ == other.allocator_) {
+					reset();
+					ops_ = std::exchange(other.ops_, nullptr);
+					ptr_ = std::exchange(other.ptr_, nullptr);
+				}
+				else {
+					void* p = other.ops_ ? other.ops_->move(other.ptr_, allocator_) : nullptr;
+					reset();
+					ops_ = other.ops_;
+					ptr_ = p;
+					other.reset();
+				}
+				return *this;
+			}
+
+			~allocator_holder() { reset(); }
+
+			void reset() {
+				if (ops_) ops_->destroy(ptr_, allocator_);
+				ops_ = nullptr;
+				ptr_ = nullptr;
+			}
+
+			allocator_type get_allocator()const { return allocator_; }
+			void* get_ptr() { return ptr_; }
+			const void* get_ptr()const { return ptr_; }
+		};
+
+		// Values of unique_holder are allocated with their destroy function stored
+		// immediately before them, so the holder needs nothing but the value
+		// pointer.
+		using destroy_fun = ptr<void(void*)>;
+
+		template<typename T>
+		struct prefixed_value {
+			static constexpr std::size_t align = alignof(T) > alignof(destroy_fun) ?
+				alignof(T) : alignof(destroy_fun);
+			static constexpr std::size_t header = alignof(T) > sizeof(destroy_fun) ?
+				alignof(T) : sizeof(destroy_fun);
+
+			static void* allocate() {
+				if constexpr (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+					return ::operator new(header + sizeof(T), std::align_val_t(align));
+				}
+				else {
+					return ::operator new(header + sizeof(T));
+				}
+			}
+
+			static void deallocate(void* block) {
+				if constexpr (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+					::operator delete(block, std::align_val_t(align));
+				}
+				else {
+					::operator delete(block);
+				}
+			}
+
+			template<typename U>
+			static T* create(U&& u) {
+				auto block = static_cast<unsigned char*>(allocate());
+				T* t;
+				try {
+					t = ::new (static_cast<void*>(block + header)) T(std::forward<U>(u));
+				}
+				catch (...) {
+					deallocate(block);
+					throw;
+				}
+				::new (static_cast<void*>(block + header - sizeof(destroy_fun))) destroy_fun(&destroy);
+				return t;
+			}
+
+			static void destroy(void* t) {
+				static_cast<T*>(t)->~T();
+				deallocate(static_cast<unsigned char*>(t) - header);
+			}
+		};
+
+		inline void destroy_prefixed(void* t) {
+			auto destroy = *std::launder(reinterpret_cast<destroy_fun*>(
+				static_cast<unsigned char*>(t) - sizeof(destroy_fun)));
+			destroy(t);
+		}
+
+		// Move only, single pointer holder. Accepts move only types.
+		class unique_holder {
+			void* ptr_ = nullptr;
+		public:
+			template<typename T>
+			unique_holder(T t, value_tag) :ptr_(prefixed_value<T>::create(std::move(t))) {}
+
+			unique_holder(unique_holder&& other)noexcept :ptr_(std::exchange(other.ptr_, nullptr)) {}
+			unique_holder& operator=(unique_holder&& other)noexcept {
+				if (this != &other) {
+					reset();
+					ptr_ = std::exchange(other.ptr_, nullptr);
+				}
+				return *this;
+			}
+			~unique_holder() { reset(); }
+
+			void reset() {
+				if (ptr_) destroy_prefixed(ptr_);
+				ptr_ = nullptr;
+			}
+
+			void* get_ptr() { return ptr_; }
+			const void* get_ptr()const { return ptr_; }
+		};
+
+		// The reference count lives in the same allocation as the value. Count is
+		// either std::size_t (single threaded) or std::atomic<std::size_t>.
+		template<typename Count>
+		struct counted_base {
+			Count count_{ 1 };
+			ptr<void(counted_base*)> destroy_;
+			const void* ptr_;
+		};
+
+		template<typename T, typename Count>
+		struct counted_impl :counted_base<Count> {
+			counted_impl(T t) :counted_base<Count>{ 1, &destroy, nullptr }, t_(std::move(t)) {
+				this->ptr_ = &t_;
+			}
+			static void destroy(counted_base<Count>* c) {
+				delete static_cast<counted_impl*>(c);
+			}
+			T t_;
+		};
+
+		template<typename Count>
+		class intrusive_holder {
+			counted_base<Count>* impl_ = nullptr;
+			const void* ptr_ = nullptr;
+
+			void add_ref() {
+				if (!impl_) return;
+				if constexpr (std::is_integral_v<Count>) {
+					++impl_->count_;
+				}
+				else {
+					impl_->count_.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+			void release() {
+				if (!impl_) return;
+				if constexpr (std::is_integral_v<Count>) {
+					if (--impl_->count_ == 0) impl_->destroy_(impl_);
+				}
+				else {
+					if (impl_->count_.fetch_sub(1, std::memory_order_release) == 1) {
+						std::atomic_thread_fence(std::memory_order_acquire);
+						impl_->destroy_(impl_);
+					}
+				}
+			}
+
+		public:
+			template<typename T>
+			intrusive_holder(T t, value_tag) :impl_(new counted_impl<T, Count>(std::move(t))),
+				ptr_(impl_->ptr_) {}
+
+			intrusive_holder(const intrusive_holder& other) :impl_(other.impl_), ptr_(other.ptr_) {
+				add_ref();
+			}
+			intrusive_holder& operator=(const intrusive_holder& other) {
+				return (*this) = intrusive_holder(other);
+			}
+			intrusive_holder(intrusive_holder&& other)noexcept :impl_(other.impl_), ptr_(other.ptr_) {
+				other.impl_ = nullptr;
+				other.ptr_ = nullptr;
+			}
+			intrusive_holder& operator=(intrusive_holder&& other)noexcept {
+				if (this != &other) {
+					release();
+					impl_ = std::exchange(other.impl_, nullptr);
+					ptr_ = std::exchange(other.ptr_, nullptr);
+				}
+				return *this;
+			}
+			~intrusive_holder() { release(); }
+
+			const void* get_ptr()const { return ptr_; }
+		};
+
 		template<typename T>
 		struct ptr_holder {
 			T* ptr_;
-			T* get_ptr()const { return ptr_; }
+			constexpr T* get_ptr()const { return ptr_; }
 			template<typename V>
-			ptr_holder(V& v, value_tag) :ptr_(&v) {}
+			constexpr ptr_holder(V& v, value_tag) :ptr_(&v) {}
 
 			template<typename OtherT>
-			ptr_holder(const ptr_holder<OtherT>& other) : ptr_(other.get_ptr()) {}
+			constexpr ptr_holder(const ptr_holder<OtherT>& other) : ptr_(other.get_ptr()) {}
 			template<typename OtherT>
 			ptr_holder& operator=(const ptr_holder<OtherT>& other) {
 				return (*this) = ptr_holder(other);
@@ -227,6 +775,18 @@ namespace polymorphic {
 			ptr_holder(value_holder& v) :ptr_(v.get_ptr()) {}
 			ptr_holder(const value_holder& v) :ptr_(v.get_ptr()) {}
 			ptr_holder(const shared_ptr_holder& v) :ptr_(v.get_ptr()) {}
+			template<std::size_t Size, std::size_t Align>
+			ptr_holder(inline_holder<Size, Align>& v) :ptr_(v.get_ptr()) {}
+			template<std::size_t Size, std::size_t Align>
+			ptr_holder(const inline_holder<Size, Align>& v) :ptr_(v.get_ptr()) {}
+			template<typename Count>
+			ptr_holder(const intrusive_holder<Count>& v) :ptr_(v.get_ptr()) {}
+			ptr_holder(unique_holder& v) :ptr_(v.get_ptr()) {}
+			ptr_holder(const unique_holder& v) :ptr_(v.get_ptr()) {}
+			template<typename Allocator>
+			ptr_holder(allocator_holder<Allocator>& v) :ptr_(v.get_ptr()) {}
+			template<typename Allocator>
+			ptr_holder(const allocator_holder<Allocator>& v) :ptr_(v.get_ptr()) {}
 	
 		};
 
@@ -240,11 +800,135 @@ namespace polymorphic {
 		const void, void>>,
 		std::make_index_sequence<sizeof...(Signatures)>, Signatures...>;
 
-	template <typename... Signatures>
-	using object = detail::ref_impl<
-		std::conditional_t<
-		std::conjunction_v<detail::is_const_signature<Signatures>...>,
-		detail::shared_ptr_holder, detail::value_holder >,
+	// Storage policies for basic_object.
+	// heap_storage allocates every value (sharing it when all signatures are const).
+	struct heap_storage {};
+	// inline_storage keeps values of up to Size bytes inside the object itself, and
+	// falls back to the heap for larger, overaligned or throwing-move types.
+	template <std::size_t Size = 4 * sizeof(void*),
+		std::size_t Align = alignof(std::max_align_t)>
+	struct inline_storage {};
+
+	// allocator_storage allocates every value with Allocator, which can be passed
+	// to the object with std::allocator_arg.
+	template <typename Allocator>
+	struct allocator_storage {};
+
+	// unique_storage owns a heap allocated value, with no copy support. Objects
+	// are move only, and so may hold move only types.
+	struct unique_storage {};
+
+	// shared_storage shares one reference counted allocation between copies. It
+	// requires all signatures to be const. Use single_threaded when the object and
+	// its copies never leave one thread, to avoid atomic reference counting.
+	struct single_threaded {};
+	struct multi_threaded {};
+	template <typename Threading = multi_threaded>
+	struct shared_storage {};
+
+	namespace detail {
+		template <typename Storage, bool IsConst> struct storage_holder;
+
+		template <bool IsConst> struct storage_holder<heap_storage, IsConst> {
+			using type = std::conditional_t<IsConst, shared_ptr_holder, value_holder>;
+		};
+
+		template <std::size_t Size, std::size_t Align, bool IsConst>
+		struct storage_holder<inline_storage<Size, Align>, IsConst> {
+			using type = inline_holder<Size, Align>;
+		};
+
+		template <bool IsConst>
+		struct storage_holder<unique_storage, IsConst> {
+			using type = unique_holder;
+		};
+
+		template <typename Allocator, bool IsConst>
+		struct storage_holder<allocator_storage<Allocator>, IsConst> {
+			using type = allocator_holder<Allocator>;
+		};
+
+		template <bool IsConst>
+		struct storage_holder<shared_storage<single_threaded>, IsConst> {
+			static_assert(IsConst, "shared_storage requires all signatures to be const.");
+			using type = intrusive_holder<std::size_t>;
+		};
+
+		template <bool IsConst>
+		struct storage_holder<shared_storage<multi_threaded>, IsConst> {
+			static_assert(IsConst, "shared_storage requires all signatures to be const.");
+			using type = intrusive_holder<std::atomic<std::size_t>>;
+		};
+	} // namespace detail
+
+	template <typename Storage, typename... Signatures>
+	using basic_object = detail::ref_impl<
+		typename detail::storage_holder<Storage,
+		std::conjunction_v<detail::is_const_signature<Signatures>...>>::type,
 		std::make_index_sequence<sizeof...(Signatures)>, Signatures...>;
 
+	template <typename... Signatures>
+	using object = basic_object<heap_storage, Signatures...>;
+
+	template <typename... Signatures>
+	using inline_object = basic_object<inline_storage<>, Signatures...>;
+
+	template <typename... Signatures>
+	using unique_object = basic_object<unique_storage, Signatures...>;
+
+	template <typename... Signatures>
+	using shared_object = basic_object<shared_storage<>, Signatures...>;
+
+	namespace pmr {
+		template <typename... Signatures>
+		using object = basic_object<
+			allocator_storage<std::pmr::polymorphic_allocator<std::byte>>, Signatures...>;
+	} // namespace pmr
+
+	namespace detail {
+		// Calls f on every element of range, after prefetching the element
+		// Distance ahead.
+		template <std::size_t Distance, typename Range, typename F>
+		void for_each_prefetched(Range& range, F f) {
+			using std::begin;
+			using std::end;
+			auto ahead = begin(range);
+			auto last = end(range);
+			for (std::size_t i = 0; i < Distance && ahead != last; ++i, ++ahead) {
+				ahead->prefetch();
+			}
+			for (auto iter = begin(range); iter != last; ++iter) {
+				if (ahead != last) {
+					ahead->prefetch();
+					++ahead;
+				}
+				f(*iter);
+			}
+		}
+	} // namespace detail
+
+	// Calls Method on every ref or object in range, prefetching the value and
+	// vtable of the element Distance ahead, which hides the cache misses of
+	// values spread over the heap. Parameters are passed to every call as
+	// lvalues, and return values are discarded.
+	template <typename Method, std::size_t Distance = 16, typename Range, typename... Parameters>
+	void call_all(Range&& range, Parameters&&... parameters) {
+		detail::for_each_prefetched<Distance>(range, [&](auto& o) {
+			o.template call<Method>(parameters...);
+			});
+	}
+
+	// Like call_all, but writes the result of each call to out, and returns the
+	// end of the output.
+	template <typename Method, std::size_t Distance = 16, typename Range,
+		typename OutputIterator, typename... Parameters>
+	OutputIterator call_all_into(Range&& range, OutputIterator out,
+		Parameters&&... parameters) {
+		detail::for_each_prefetched<Distance>(range, [&](auto& o) {
+			*out = o.template call<Method>(parameters...);
+			++out;
+			});
+		return out;
+	}
+
 } // namespace polymorphic
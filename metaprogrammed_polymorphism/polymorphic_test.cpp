@@ -12,8 +12,19 @@
 // limitations under the License.
 
 #include <gmock/gmock.h>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <thread>
+#include <vector>
 #include "polymorphic.hpp"
+#include "atomic_object.hpp"
+#include "closed_object.hpp"
+#include "instrumentation.hpp"
+#include "poly_collection.hpp"
 
 struct x2 {};
 struct stupid_hash {};
@@ -164,7 +175,505 @@ TEST(Polymorphic, CopyConstRefFromObject) {
 
 }
 
+struct name {};
+std::string poly_extend(name, const int&) { return "int"; }
+std::string poly_extend(name, const std::string&) { return "string"; }
+
+TEST(Polymorphic, ReorderedRefFromObject) {
+	std::vector<polymorphic::object<void(x2), int(stupid_hash)const, std::string(name)const>> objects;
+	objects.emplace_back(5);
+	objects.emplace_back(std::string("hello"));
+	for (auto& o : objects) {
+		polymorphic::ref<std::string(name)const, void(x2)> r = o;
+		static_assert(sizeof(r) == 2 * sizeof(void*));
+		r.call<x2>();
+		polymorphic::ref<void(x2)> r2 = r;
+		r2.call<x2>();
+		polymorphic::ref<std::string(name)const> r3 = r;
+		polymorphic::ref<int(stupid_hash)const, std::string(name)const> r4 = std::as_const(o);
+		EXPECT_THAT(r3.call<name>(), r4.call<name>());
+	}
+	EXPECT_THAT(objects[0].call<stupid_hash>(), 20);
+	EXPECT_THAT(objects[1].call<stupid_hash>(), 20);
+	EXPECT_THAT(objects[0].call<name>(), "int");
+	EXPECT_THAT(objects[1].call<name>(), "string");
+}
+
+struct constant_id {};
+int poly_extend(constant_id, const int&) { return 1; }
+int poly_extend(constant_id, const double&) { return 2; }
+
+constexpr int constant_int = 3;
+constexpr double constant_double = 1.5;
+constexpr polymorphic::ref<int(stupid_hash) const> constant_ref = constant_int;
+constexpr std::array<polymorphic::ref<int(constant_id) const, int(stupid_hash) const>, 2>
+constant_table{ constant_int, constant_int };
+constexpr std::array<polymorphic::ref<int(constant_id) const>, 2> constant_id_table{
+	constant_int, constant_double };
+
+TEST(Polymorphic, ConstexprRef) {
+	EXPECT_THAT(constant_ref.call<stupid_hash>(), 3);
+	EXPECT_THAT(constant_table[1].call<stupid_hash>(), 3);
+	EXPECT_THAT(constant_table[1].call<constant_id>(), 1);
+	EXPECT_THAT(constant_id_table[0].call<constant_id>(), 1);
+	EXPECT_THAT(constant_id_table[1].call<constant_id>(), 2);
+
+	polymorphic::ref<int(stupid_hash) const> r = constant_table[0];
+	EXPECT_THAT(r.call<stupid_hash>(), 3);
+}
+
+TEST(Polymorphic, InlineObjectStoresSmallTypesInline) {
+	polymorphic::inline_object<void(x2), int(stupid_hash)const> o{ 5 };
+	const char* begin = reinterpret_cast<const char*>(&o);
+	const char* p = static_cast<const char*>(std::as_const(o).get_ptr());
+	EXPECT_TRUE(p >= begin && p < begin + sizeof(o));
+
+	o.call<x2>();
+	EXPECT_THAT(o.call<stupid_hash>(), 10);
+}
+
+TEST(Polymorphic, CopyInlineObject) {
+	polymorphic::inline_object<void(x2)> o{ std::string("hello") };
+	auto o2 = o;
+
+	o.call<x2>();
+	const auto& s_ref = *static_cast<std::string*>(o.get_ptr());
+	const auto& s_ref2 = *static_cast<std::string*>(o2.get_ptr());
+	EXPECT_THAT(s_ref, "hellohello");
+	EXPECT_THAT(s_ref2, "hello");
+
+	auto o3 = std::move(o);
+	EXPECT_THAT(*static_cast<std::string*>(o3.get_ptr()), "hellohello");
+	o3 = o2;
+	o3.call<x2>();
+	EXPECT_THAT(*static_cast<std::string*>(o3.get_ptr()), "hellohello");
+	EXPECT_THAT(*static_cast<std::string*>(o2.get_ptr()), "hello");
+}
+
+struct big {
+	std::array<int, 64> values{};
+};
+int poly_extend(stupid_hash, const big& b) { return b.values[0]; }
+
+TEST(Polymorphic, InlineObjectFallsBackToHeap) {
+	big b;
+	b.values[0] = 7;
+	polymorphic::basic_object<polymorphic::inline_storage<8>, int(stupid_hash)const> o{ b };
+	const char* begin = reinterpret_cast<const char*>(&o);
+	const char* p = static_cast<const char*>(o.get_ptr());
+	EXPECT_FALSE(p >= begin && p < begin + sizeof(o));
+
+	auto o2 = o;
+	auto o3 = std::move(o);
+	EXPECT_THAT(o2.call<stupid_hash>(), 7);
+	EXPECT_THAT(o3.call<stupid_hash>(), 7);
+
+	polymorphic::ref<int(stupid_hash)const> r = o2;
+	EXPECT_THAT(r.call<stupid_hash>(), 7);
+}
+
+template <typename Object>
+void SharedObjectTest() {
+	Object o{ std::string("hello") };
+	auto o2 = o;
+	EXPECT_THAT(o.get_ptr(), o2.get_ptr());
+	EXPECT_THAT(o2.template call<stupid_hash>(), 5);
+
+	Object o3{ 7 };
+	o2 = o3;
+	EXPECT_THAT(o2.template call<stupid_hash>(), 7);
+	o3 = std::move(o);
+	EXPECT_THAT(o3.template call<stupid_hash>(), 5);
+
+	polymorphic::ref<int(stupid_hash)const> r = o3;
+	EXPECT_THAT(r.call<stupid_hash>(), 5);
+}
+
+TEST(Polymorphic, SharedObject) {
+	SharedObjectTest<polymorphic::shared_object<int(stupid_hash)const>>();
+}
+
+TEST(Polymorphic, SingleThreadedSharedObject) {
+	SharedObjectTest<polymorphic::basic_object<
+		polymorphic::shared_storage<polymorphic::single_threaded>, int(stupid_hash)const>>();
+}
+
+void poly_extend(x2, std::unique_ptr<int>& p) { *p *= 2; }
+int poly_extend(stupid_hash, const std::unique_ptr<int>& p) { return *p; }
+
+struct alignas(64) overaligned {
+	int value = 3;
+};
+int poly_extend(stupid_hash, const overaligned& o) {
+	return reinterpret_cast<std::uintptr_t>(&o) % 64 == 0 ? o.value : -1;
+}
+void poly_extend(x2, overaligned& o) { o.value *= 2; }
+
+TEST(Polymorphic, UniqueObject) {
+	using unique = polymorphic::unique_object<void(x2), int(stupid_hash)const>;
+	static_assert(sizeof(unique) == 2 * sizeof(void*));
+	static_assert(!std::is_copy_constructible_v<unique>);
+
+	unique o{ std::make_unique<int>(5) };
+	o.call<x2>();
+	EXPECT_THAT(o.call<stupid_hash>(), 10);
+
+	unique o2 = std::move(o);
+	EXPECT_THAT(o.get_ptr(), nullptr);
+	polymorphic::ref<int(stupid_hash)const> r = std::as_const(o2);
+	EXPECT_THAT(r.call<stupid_hash>(), 10);
+
+	o2 = std::string("hello");
+	EXPECT_THAT(o2.call<stupid_hash>(), 5);
+
+	o2 = overaligned{};
+	o2.call<x2>();
+	EXPECT_THAT(o2.call<stupid_hash>(), 6);
+}
 
+class counting_resource :public std::pmr::memory_resource {
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+		++allocations;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+		++deallocations;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+public:
+	int allocations = 0;
+	int deallocations = 0;
+};
+
+TEST(Polymorphic, PmrObject) {
+	counting_resource resource;
+	{
+		polymorphic::pmr::object<void(x2), int(stupid_hash)const> o{ std::allocator_arg, &resource,
+			std::string("hello") };
+		EXPECT_THAT(resource.allocations, 1);
+		o.call<x2>();
+		EXPECT_THAT(o.call<stupid_hash>(), 10);
+
+		// Assignment keeps the resource of the target.
+		o = 5;
+		EXPECT_THAT(resource.allocations, 2);
+		EXPECT_THAT(resource.deallocations, 1);
+		EXPECT_THAT(o.call<stupid_hash>(), 5);
+
+		auto o2 = std::move(o);
+		EXPECT_THAT(resource.allocations, 2);
+		EXPECT_THAT(o2.call<stupid_hash>(), 5);
+
+		polymorphic::pmr::object<void(x2), int(stupid_hash)const> o3{ std::allocator_arg, &resource, 1 };
+		o3 = o2;
+		o3.call<x2>();
+		EXPECT_THAT(o3.call<stupid_hash>(), 10);
+		EXPECT_THAT(o2.call<stupid_hash>(), 5);
+		EXPECT_THAT(resource.allocations, 4);
+	}
+	EXPECT_THAT(resource.deallocations, resource.allocations);
+}
+
+struct sum_hash {};
+void poly_extend(sum_hash, const int& i, int& sum) { sum += i; }
+void poly_extend(sum_hash, const std::string& s, int& sum) { sum += static_cast<int>(s.size()); }
+
+TEST(Polymorphic, CallAll) {
+	std::vector<polymorphic::object<void(x2), int(stupid_hash) const>> objects;
+	for (int i = 0; i < 20; ++i) {
+		if (i % 2) {
+			objects.emplace_back(i);
+		}
+		else {
+			objects.emplace_back(std::string("ab"));
+		}
+	}
+	polymorphic::call_all<x2>(objects);
+
+	std::vector<int> hashes(objects.size());
+	auto end = polymorphic::call_all_into<stupid_hash, 4>(objects, hashes.begin());
+	EXPECT_TRUE(end == hashes.end());
+	for (int i = 0; i < 20; ++i) {
+		EXPECT_THAT(hashes[i], (i % 2) ? 2 * i : 4);
+	}
+
+	std::vector<polymorphic::ref<int(stupid_hash) const>> refs(objects.begin(), objects.end());
+	std::vector<int> ref_hashes;
+	polymorphic::call_all_into<stupid_hash>(refs, std::back_inserter(ref_hashes));
+	EXPECT_THAT(ref_hashes, hashes);
+}
+
+TEST(AtomicObject, LoadStoreExchange) {
+	polymorphic::atomic_object<int(stupid_hash) const> a(std::string("hello"));
+	auto h = a.load();
+	EXPECT_THAT(h.call<stupid_hash>(), 5);
+
+	// The handle keeps the old value alive after it is replaced.
+	a.store(7);
+	EXPECT_THAT(h.call<stupid_hash>(), 5);
+	polymorphic::ref<int(stupid_hash) const> r = h.get();
+	EXPECT_THAT(r.call<stupid_hash>(), 5);
+	h.reset();
+
+	EXPECT_THAT(a.load().call<stupid_hash>(), 7);
+	auto old = a.exchange(std::string("ab"));
+	EXPECT_THAT(old.call<stupid_hash>(), 7);
+	EXPECT_THAT(a.load().call<stupid_hash>(), 2);
+}
+
+TEST(AtomicObject, ConcurrentReadersAndWriter) {
+	polymorphic::atomic_object<int(stupid_hash) const> a(0);
+	std::atomic<bool> done{ false };
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; ++t) {
+		readers.emplace_back([&]() {
+			int last = 0;
+			while (!done.load()) {
+				auto h = a.load();
+				int value = h.call<stupid_hash>();
+				EXPECT_GE(value, last);
+				last = value;
+			}
+			});
+	}
+	for (int i = 1; i <= 1000; ++i) {
+		if (i % 2) {
+			a.store(i);
+		}
+		else {
+			a.store(std::string(static_cast<std::size_t>(i), 'x'));
+		}
+	}
+	done = true;
+	for (auto& t : readers) t.join();
+	EXPECT_THAT(a.load().call<stupid_hash>(), 1000);
+}
+
+TEST(PolyCollection, ForEachCall) {
+	polymorphic::poly_collection<void(x2), void(sum_hash, int&)const> c;
+	c.insert(1);
+	c.insert(std::string("hello"));
+	c.insert(2);
+	c.emplace<std::string>("abc");
+	EXPECT_THAT(c.size(), 4);
+	EXPECT_THAT(c.segment_count(), 2);
+
+	int sum = 0;
+	c.for_each_call<sum_hash>(sum);
+	EXPECT_THAT(sum, 11);
+
+	c.for_each_call<x2>();
+	sum = 0;
+	std::as_const(c).for_each_call<sum_hash>(sum);
+	EXPECT_THAT(sum, 22);
+}
+
+struct count_longer {};
+void poly_extend(count_longer, const int& i, std::size_t length, int* count) {
+	if (static_cast<std::size_t>(i) > length) ++*count;
+}
+void poly_extend(count_longer, const std::string& s, std::size_t length, int* count) {
+	if (s.size() > length) ++*count;
+}
+
+TEST(PolyCollection, ConvertsArguments) {
+	polymorphic::poly_collection<void(count_longer, std::size_t, int*)const> c;
+	c.insert(1);
+	c.insert(std::string("hello"));
+	c.insert(7);
+
+	int count = 0;
+	const int length = 2;
+	c.for_each_call<count_longer>(length, &count);
+	EXPECT_THAT(count, 2);
+	c.for_each_call<count_longer>(5, &count);
+	EXPECT_THAT(count, 3);
+}
+
+TEST(PolyCollection, Copy) {
+	polymorphic::poly_collection<void(x2), void(sum_hash, int&)const> c;
+	c.insert(1);
+	c.insert(std::string("hello"));
+	auto c2 = c;
+	c.for_each_call<x2>();
+	c2.insert(3);
+
+	int sum = 0;
+	c.for_each_call<sum_hash>(sum);
+	EXPECT_THAT(sum, 12);
+	sum = 0;
+	c2.for_each_call<sum_hash>(sum);
+	EXPECT_THAT(sum, 9);
+
+	c.clear();
+	EXPECT_TRUE(c.empty());
+	EXPECT_THAT(c.segment_count(), 2);
+}
+
+TEST(ClosedObject, Call) {
+	using closed = polymorphic::closed_object<polymorphic::type_list<int, std::string>,
+		void(x2), int(stupid_hash)const>;
+	closed o{ std::string("hello") };
+	EXPECT_THAT(o.index(), 1);
+	o.call<x2>();
+	EXPECT_THAT(std::as_const(o).call<stupid_hash>(), 10);
+
+	o = 5;
+	EXPECT_THAT(o.index(), 0);
+	o.call<x2>();
+	EXPECT_THAT(o.call<stupid_hash>(), 10);
+}
+
+TEST(ClosedObject, Copy) {
+	using closed = polymorphic::closed_object<polymorphic::type_list<int, std::string>,
+		void(x2), int(stupid_hash)const>;
+	closed o{ std::string("hello") };
+	auto o2 = o;
+	o.call<x2>();
+	EXPECT_THAT(*static_cast<const std::string*>(o.get_ptr()), "hellohello");
+	EXPECT_THAT(*static_cast<const std::string*>(o2.get_ptr()), "hello");
+
+	closed o3{ 1 };
+	o3 = std::move(o);
+	EXPECT_THAT(o3.call<stupid_hash>(), 10);
+	o2 = o3;
+	EXPECT_THAT(o2.call<stupid_hash>(), 10);
+
+	static_assert(std::is_nothrow_move_constructible_v<closed>);
+	static_assert(std::is_nothrow_move_assignable_v<closed>);
+	static_assert(!std::is_constructible_v<closed, double>);
+}
+
+struct interact {};
+std::string poly_extend(interact, const int& a, const std::string& b, const std::string& prefix) {
+	return prefix + "int-string " + std::to_string(a) + b;
+}
+std::string poly_extend(interact, const std::string& a, const int& b, const std::string& prefix) {
+	return prefix + "string-int " + a + std::to_string(b);
+}
+template <typename A>
+std::string poly_extend(interact, const A&, const A&, const std::string& prefix) {
+	return prefix + "same";
+}
+
+struct swap_values {};
+void poly_extend(swap_values, int& a, int& b) { std::swap(a, b); }
+template <typename A, typename B>
+void poly_extend(swap_values, A&, B&) {}
+
+struct first_value {};
+template <typename A, typename B>
+const A& poly_extend(first_value, const A& a, const B&) { return a; }
+
+TEST(ClosedObject, Call2) {
+	using closed = polymorphic::closed_object<polymorphic::type_list<int, std::string>,
+		int(stupid_hash)const>;
+	const closed i{ 1 };
+	const closed s{ std::string("a") };
+	std::string prefix = "> ";
+	EXPECT_THAT(polymorphic::call2<interact>(i, s, prefix), "> int-string 1a");
+	EXPECT_THAT(polymorphic::call2<interact>(s, i, prefix), "> string-int a1");
+	EXPECT_THAT(polymorphic::call2<interact>(i, i, prefix), "> same");
+	EXPECT_THAT(polymorphic::call2<interact>(s, s, prefix), "> same");
+}
+
+TEST(ClosedObject, Call2Fallback) {
+	using closed = polymorphic::closed_object<polymorphic::type_list<int, std::string>,
+		int(stupid_hash)const>;
+	closed a{ 1 };
+	closed b{ 2 };
+	closed s{ std::string("a") };
+	polymorphic::call2<swap_values>(a, b);
+	EXPECT_THAT(a.call<stupid_hash>(), 2);
+	EXPECT_THAT(b.call<stupid_hash>(), 1);
+	polymorphic::call2<swap_values>(a, s);
+	EXPECT_THAT(a.call<stupid_hash>(), 2);
+
+	using ints = polymorphic::closed_object<polymorphic::type_list<int>,
+		int(stupid_hash)const>;
+	const ints one{ 1 };
+	const ints two{ 2 };
+	const int& first = polymorphic::call2<first_value>(one, two);
+	EXPECT_THAT(&first, one.get_ptr());
+}
+
+
+struct counted_hash {};
+int poly_extend(counted_hash, const int& i) { return i; }
+int poly_extend(counted_hash, const std::string& s) { return static_cast<int>(s.size()); }
+
+const polymorphic::call_stats* FindStats(const std::vector<polymorphic::call_stats>& stats,
+	const std::string& method, const std::string& type) {
+	for (auto& s : stats) {
+		if (s.method == method && s.type.find(type) != std::string::npos) return &s;
+	}
+	return nullptr;
+}
+
+TEST(Instrumentation, CountsCallsPerType) {
+	using counted = polymorphic::basic_object<polymorphic::instrumented<polymorphic::heap_storage, 1>,
+		int(counted_hash) const, void(x2)>;
+	counted i{ 5 };
+	counted s{ std::string("hello") };
+	for (int n = 0; n < 3; ++n) i.call<counted_hash>();
+	s.call<counted_hash>();
+	s.call<x2>();
+
+	// Refs made from an instrumented object share its instrumented vtable.
+	polymorphic::ref<int(counted_hash) const> r(s);
+	EXPECT_THAT(r.call<counted_hash>(), 10);
+
+	auto stats = polymorphic::instrumentation_snapshot();
+	auto int_stats = FindStats(stats, "counted_hash", "int");
+	auto string_stats = FindStats(stats, "counted_hash", "basic_string");
+	ASSERT_NE(int_stats, nullptr);
+	ASSERT_NE(string_stats, nullptr);
+	EXPECT_THAT(int_stats->calls, 3);
+	EXPECT_THAT(int_stats->sampled_calls, 3);
+	EXPECT_THAT(string_stats->calls, 2);
+	ASSERT_NE(FindStats(stats, "x2", "basic_string"), nullptr);
+	EXPECT_THAT(FindStats(stats, "x2", "basic_string")->calls, 1);
+}
+
+TEST(Instrumentation, InstrumentedRef) {
+	int i = 3;
+	polymorphic::instrumented_ref<int(stupid_hash) const> r(i);
+	EXPECT_THAT(r.call<stupid_hash>(), 3);
+	EXPECT_THAT(r.call<stupid_hash>(), 3);
+
+	auto stats = polymorphic::instrumentation_snapshot();
+	ASSERT_NE(FindStats(stats, "stupid_hash", "int"), nullptr);
+	EXPECT_THAT(FindStats(stats, "stupid_hash", "int")->calls, 2);
+	// Sampled every 64 calls, starting with the first.
+	EXPECT_THAT(FindStats(stats, "stupid_hash", "int")->sampled_calls, 1);
+}
+
+struct thread_hash {};
+int poly_extend(thread_hash, const int& i) { return i; }
+
+TEST(Instrumentation, ReusesCountersOfExitedThreads) {
+	using counted = polymorphic::basic_object<polymorphic::instrumented<polymorphic::heap_storage>,
+		int(thread_hash) const>;
+	const counted i{ 1 };
+	auto blocks = [] {
+		std::size_t n = 0;
+		polymorphic::detail::get_call_registry().for_each([&](const auto&) { ++n; });
+		return n;
+	};
+	std::thread([&] { i.call<thread_hash>(); }).join();
+	auto blocks_after_first_thread = blocks();
+	for (int n = 0; n < 10; ++n) {
+		std::thread([&] { i.call<thread_hash>(); }).join();
+	}
+	EXPECT_THAT(blocks(), blocks_after_first_thread);
+
+	auto stats = polymorphic::instrumentation_snapshot();
+	ASSERT_NE(FindStats(stats, "thread_hash", "int"), nullptr);
+	EXPECT_THAT(FindStats(stats, "thread_hash", "int")->calls, 11);
+}
 
 
 int main(int argc, char **argv) {
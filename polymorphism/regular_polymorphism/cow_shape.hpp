@@ -0,0 +1,74 @@
+#pragma once
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "shapes_interface.hpp"
+
+namespace my_shapes {
+
+	// Like shape, but copies share one reference counted implementation, so
+	// copying is a pointer copy. A shared implementation is only cloned when it
+	// is about to be mutated through get_if.
+	//
+	// Whether it is shared is read from shared_ptr::use_count(), which is only
+	// exact while no other thread copies or destroys copies of the same shape.
+	// Copies can be drawn on several threads at once, but the mutating get_if,
+	// and shared, must not run while another thread copies or destroys any copy
+	// that shares the implementation.
+	class cow_shape {
+	public:
+		cow_shape() = default;
+		template <typename T, typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, cow_shape>>>
+		explicit cow_shape(T&& t)
+			: ptr_(std::make_shared<shape_implementation<std::decay_t<T>>>(std::forward<T>(t))) {}
+
+		void draw()const {
+			if (ptr_)
+				ptr_->draw_();
+			else
+				draw_implementation(empty_shape{});
+		}
+
+		// The stored shape if it is a T, or nullptr.
+		template <typename T>
+		const T* get_if() const {
+			auto impl = dynamic_cast<const shape_implementation<T>*>(ptr_.get());
+			return impl ? &impl->t_ : nullptr;
+		}
+
+		// The stored shape if it is a T, or nullptr. Clones the shape first if
+		// other copies share it, so the pointer can be used to mutate this copy.
+		template <typename T>
+		T* get_if() {
+			if (!std::as_const(*this).template get_if<T>()) return nullptr;
+			if (ptr_.use_count() > 1) ptr_ = ptr_->clone_();
+			return &static_cast<shape_implementation<T>&>(*ptr_).t_;
+		}
+
+		bool shared() const { return ptr_.use_count() > 1; }
+
+	private:
+		struct shape_interface {
+			virtual void draw_() const = 0;
+			virtual std::shared_ptr<shape_interface> clone_() const = 0;
+			virtual ~shape_interface() = default;
+		};
+
+		template <typename T>
+		struct shape_implementation : shape_interface {
+			void draw_() const override {
+				draw_to_output(t_);
+			}
+			std::shared_ptr<shape_interface> clone_() const override {
+				return std::make_shared<shape_implementation>(t_);
+			}
+			template <typename U>
+			explicit shape_implementation(U&& u) : t_(std::forward<U>(u)) {}
+
+			T t_;
+		};
+
+		std::shared_ptr<shape_interface> ptr_;
+	};
+
+}  // namespace my_shapes
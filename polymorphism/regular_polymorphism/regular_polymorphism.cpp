@@ -1,6 +1,8 @@
 #include <iostream>
 #include <memory>
 #include <vector>
+#include "cow_shape.hpp"
+#include "shape_collection.hpp"
 #include "shapes.hpp"
 #include "shapes_drawer.hpp"
 
@@ -18,5 +20,25 @@ int main() {
 
 	draw_shapes(shapes);
 
+	// Prints the same as above.
+	thread_pool pool(2);
+	draw_shapes(shapes, pool, 2);
+
+	my_shapes::shape_collection collection;
+	collection.insert(circle{});
+	collection.insert(square{});
+	collection.insert(circle{});
+	collection.insert(other_library::triangle{});
+	collection.draw_all();
+
+	std::vector<my_shapes::cow_shape> scene;
+	scene.emplace_back(circle{});
+	scene.emplace_back(square{});
+	auto snapshot = scene;
+	// Only the square is cloned.
+	scene[1].get_if<square>();
+	std::cout << std::boolalpha << scene[0].shared() << " " << scene[1].shared() << "\n";
+	for (const auto& shape : snapshot) shape.draw();
+
 
 }
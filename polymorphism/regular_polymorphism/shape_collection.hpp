@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "shapes_interface.hpp"
+
+namespace my_shapes {
+
+	// Stores shapes grouped by concrete type, each group in a contiguous vector.
+	// draw_all() makes one virtual call per group, and calls draw_implementation
+	// directly for the shapes in it. Shapes are drawn in insertion order within
+	// a group, and groups in the order their first shape was inserted.
+	class shape_collection {
+	public:
+		shape_collection() = default;
+		shape_collection(shape_collection&&) = default;
+		shape_collection(const shape_collection& other) : index_(other.index_) {
+			for (auto& g : other.groups_) groups_.push_back(g->clone_());
+		}
+		shape_collection& operator=(shape_collection&&) = default;
+		shape_collection& operator=(const shape_collection& other) {
+			auto new_collection = other;
+			(*this) = std::move(new_collection);
+			return *this;
+		}
+
+		template <typename T>
+		void insert(T&& t) {
+			group<std::decay_t<T>>().push_back(std::forward<T>(t));
+		}
+
+		template <typename T, typename... Args>
+		T& emplace(Args&&... args) {
+			return group<T>().emplace_back(std::forward<Args>(args)...);
+		}
+
+		template <typename T>
+		void reserve(std::size_t n) { group<T>().reserve(n); }
+
+		std::size_t size() const {
+			std::size_t result = 0;
+			for (auto& g : groups_) result += g->size_();
+			return result;
+		}
+
+		void draw_all() const {
+			for (auto& g : groups_) g->draw_all_();
+		}
+
+	private:
+		struct group_interface {
+			virtual void draw_all_() const = 0;
+			virtual std::size_t size_() const = 0;
+			virtual std::unique_ptr<group_interface> clone_() const = 0;
+			virtual ~group_interface() = default;
+		};
+
+		template <typename T>
+		struct group_implementation : group_interface {
+			void draw_all_() const override {
+				for (auto& t : shapes_) draw_to_output(t);
+			}
+			std::size_t size_() const override { return shapes_.size(); }
+			std::unique_ptr<group_interface> clone_() const override {
+				return std::make_unique<group_implementation>(*this);
+			}
+
+			std::vector<T> shapes_;
+		};
+
+		template <typename T>
+		std::vector<T>& group() {
+			auto iter = index_.find(typeid(T));
+			if (iter == index_.end()) {
+				iter = index_.emplace(typeid(T), groups_.size()).first;
+				groups_.push_back(std::make_unique<group_implementation<T>>());
+			}
+			return static_cast<group_implementation<T>&>(*groups_[iter->second]).shapes_;
+		}
+
+		std::vector<std::unique_ptr<group_interface>> groups_;
+		std::unordered_map<std::type_index, std::size_t> index_;
+	};
+
+}  // namespace my_shapes
@@ -2,19 +2,19 @@
 #include "shapes_interface.hpp"
 
 struct circle {
-	void draw() const { std::cout << "circle::draw\n"; }
+	void draw() const { my_shapes::output() << "circle::draw\n"; }
 };
 
 struct square {
-	void draw() const { std::cout << "square::draw\n"; }
+	void draw() const { my_shapes::output() << "square::draw\n"; }
 };
 
 struct composite {
 	std::vector<my_shapes::shape> shapes_;
 	void draw() const {
-		std::cout << "begin composite\n";
+		my_shapes::output() << "begin composite\n";
 		for (auto& s : shapes_) s.draw();
-		std::cout << "end composite\n";
+		my_shapes::output() << "end composite\n";
 	}
 };
 
@@ -29,6 +29,6 @@ namespace other_library {
 
 namespace my_namespace {
 	struct my_shape {};
-	void draw_implementation(my_shape) { std::cout << "my_shape:draw\n"; }
+	void draw_implementation(my_shape, std::ostream& out = std::cout) { out << "my_shape:draw\n"; }
 }  // namespace my_namespace
 
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "cow_shape.hpp"
+#include "shape_collection.hpp"
+#include "shapes_drawer.hpp"
+
+// Counts the bytes allocated with new, to compare the memory used by
+// snapshots.
+std::atomic<std::size_t> allocated_bytes{ 0 };
+
+void* operator new(std::size_t size) {
+	allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC does not know that new above is malloc.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Shapes that do a little work instead of printing, in a small version which
+// is stored inside shape, and a large one which does not fit and is stored on
+// the heap like every shape used to be.
+namespace benchmark_shapes {
+	template <int Padding>
+	struct circle {
+		std::array<int, Padding> radius{};
+		void draw() const { benchmark::DoNotOptimize(radius[0]); }
+	};
+
+	template <int Padding>
+	struct square {
+		std::array<int, Padding> side{};
+		void draw() const { benchmark::DoNotOptimize(side[0]); }
+	};
+
+	template <int Padding>
+	struct triangle {
+		std::array<int, Padding> base{};
+		void draw() const { benchmark::DoNotOptimize(base[0]); }
+	};
+
+	// Renders a small tile and prints a checksum of it, so that drawing has
+	// enough work to spread over threads and writes to the output.
+	struct tile {
+		unsigned seed = 0;
+		void draw() const {
+			unsigned sum = seed;
+			for (unsigned y = 0; y < 32; ++y)
+				for (unsigned x = 0; x < 32; ++x) sum = sum * 31 + ((x * x + y * y + seed) & 0xff);
+			my_shapes::output() << sum << '\n';
+		}
+	};
+
+	constexpr int small = 1;
+	constexpr int large = 16;
+}  // namespace benchmark_shapes
+
+std::vector<int> GetRandomTypes(int count) {
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<int> type(0, 2);
+	std::vector<int> types;
+	for (int i = 0; i < count; ++i) types.push_back(type(generator));
+	return types;
+}
+
+template <int Padding, typename Shape = my_shapes::shape>
+std::vector<Shape> MakeShapes(int count) {
+	using namespace benchmark_shapes;
+	std::vector<Shape> shapes;
+	for (int type : GetRandomTypes(count)) {
+		if (type == 0) shapes.emplace_back(circle<Padding>{});
+		else if (type == 1) shapes.emplace_back(square<Padding>{});
+		else shapes.emplace_back(triangle<Padding>{});
+	}
+	return shapes;
+}
+
+template <int Padding>
+static void BM_DrawShapes(benchmark::State& state) {
+	auto shapes = MakeShapes<Padding>(static_cast<int>(state.range(0)));
+	for (auto _ : state) {
+		draw_shapes(shapes);
+	}
+	state.SetItemsProcessed(state.iterations() * shapes.size());
+}
+
+static void BM_ShapeCollectionDrawAll(benchmark::State& state) {
+	using namespace benchmark_shapes;
+	my_shapes::shape_collection shapes;
+	for (int type : GetRandomTypes(static_cast<int>(state.range(0)))) {
+		if (type == 0) shapes.insert(circle<small>{});
+		else if (type == 1) shapes.insert(square<small>{});
+		else shapes.insert(triangle<small>{});
+	}
+	for (auto _ : state) {
+		shapes.draw_all();
+	}
+	state.SetItemsProcessed(state.iterations() * shapes.size());
+}
+
+std::vector<my_shapes::shape> MakeTiles(int count) {
+	std::vector<my_shapes::shape> shapes;
+	for (int i = 0; i < count; ++i) shapes.emplace_back(benchmark_shapes::tile{ static_cast<unsigned>(i) });
+	return shapes;
+}
+
+// Discards what is written to it.
+struct null_output {
+	null_output() { previous_ = std::exchange(my_shapes::current_output(), &stream_); }
+	~null_output() { my_shapes::current_output() = previous_; }
+	std::ostream stream_{ nullptr };
+	std::ostream* previous_;
+};
+
+static void BM_DrawTiles(benchmark::State& state) {
+	auto shapes = MakeTiles(static_cast<int>(state.range(0)));
+	null_output output;
+	for (auto _ : state) {
+		draw_shapes(shapes);
+	}
+	state.SetItemsProcessed(state.iterations() * shapes.size());
+}
+
+// Threads is the number of threads drawing, including the calling thread.
+static void BM_DrawTilesParallel(benchmark::State& state) {
+	auto shapes = MakeTiles(static_cast<int>(state.range(0)));
+	thread_pool pool(static_cast<std::size_t>(state.range(1) - 1));
+	null_output output;
+	for (auto _ : state) {
+		draw_shapes(shapes, pool);
+	}
+	state.SetItemsProcessed(state.iterations() * shapes.size());
+}
+
+static void ThreadCounts(benchmark::internal::Benchmark* b) {
+	int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	for (int threads = 1; threads < cores; threads *= 2) b->Args({ 100000, threads });
+	b->Args({ 100000, cores });
+}
+
+// Copies a whole scene, as done every frame for undo.
+template <int Padding, typename Shape>
+static void BM_SnapshotShapes(benchmark::State& state) {
+	auto shapes = MakeShapes<Padding, Shape>(static_cast<int>(state.range(0)));
+	std::size_t bytes = 0;
+	for (auto _ : state) {
+		auto before = allocated_bytes.load(std::memory_order_relaxed);
+		auto snapshot = shapes;
+		bytes += allocated_bytes.load(std::memory_order_relaxed) - before;
+		benchmark::DoNotOptimize(snapshot.data());
+	}
+	state.counters["bytes_per_snapshot"] = benchmark::Counter(static_cast<double>(bytes),
+		benchmark::Counter::kAvgIterations);
+	state.SetItemsProcessed(state.iterations() * shapes.size());
+}
+
+BENCHMARK_TEMPLATE(BM_DrawShapes, benchmark_shapes::large)->Arg(100000)->Arg(1000000);
+BENCHMARK_TEMPLATE(BM_DrawShapes, benchmark_shapes::small)->Arg(100000)->Arg(1000000);
+BENCHMARK(BM_ShapeCollectionDrawAll)->Arg(100000)->Arg(1000000);
+
+BENCHMARK(BM_DrawTiles)->Arg(100000)->UseRealTime();
+BENCHMARK(BM_DrawTilesParallel)->Apply(ThreadCounts)->ArgNames({ "shapes", "threads" })->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_SnapshotShapes, benchmark_shapes::large, my_shapes::shape)->Arg(1000000);
+BENCHMARK_TEMPLATE(BM_SnapshotShapes, benchmark_shapes::small, my_shapes::shape)->Arg(1000000);
+BENCHMARK_TEMPLATE(BM_SnapshotShapes, benchmark_shapes::large, my_shapes::cow_shape)->Arg(1000000);
+
+BENCHMARK_MAIN();
@@ -1,5 +1,78 @@
 #include "shapes_drawer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <string>
 
 void draw_shapes(const std::vector<my_shapes::shape>& shapes) {
 	for (const auto& shape : shapes) shape.draw();
 }
+
+void draw_shapes(const std::vector<my_shapes::shape>& shapes, thread_pool& executor,
+	std::size_t chunk_size) {
+	chunk_size = std::max<std::size_t>(chunk_size, 1);
+	const std::size_t chunks = (shapes.size() + chunk_size - 1) / chunk_size;
+	std::vector<std::string> outputs(chunks);
+	std::atomic<std::size_t> next_chunk{ 0 };
+	std::mutex mutex;
+	std::exception_ptr error;
+
+	// Threads take the next chunk until there are none left, so a slow chunk
+	// does not hold up the others.
+	auto draw_chunks = [&] {
+		auto& output = my_shapes::current_output();
+		auto previous = output;
+		try {
+			for (std::size_t chunk; (chunk = next_chunk.fetch_add(1)) < chunks;) {
+				std::ostringstream buffer;
+				output = &buffer;
+				auto first = shapes.begin() + chunk * chunk_size;
+				auto last = shapes.begin() + std::min(shapes.size(), (chunk + 1) * chunk_size);
+				std::for_each(first, last, [](const auto& shape) { shape.draw(); });
+				outputs[chunk] = buffer.str();
+			}
+		}
+		catch (...) {
+			next_chunk = chunks;
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!error) error = std::current_exception();
+		}
+		output = previous;
+	};
+
+	std::condition_variable done;
+	std::size_t running = std::min(executor.size(), chunks > 0 ? chunks - 1 : 0);
+	auto wait = [&] {
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return running == 0; });
+	};
+	for (std::size_t i = running; i > 0; --i) {
+		try {
+			executor.execute([&] {
+				draw_chunks();
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--running == 0) done.notify_one();
+				});
+		}
+		catch (...) {
+			// The tasks already queued refer to the locals above, so they are left
+			// no chunks to draw, and waited for before returning.
+			next_chunk = chunks;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				running -= i;
+			}
+			wait();
+			throw;
+		}
+	}
+	draw_chunks();
+	wait();
+	if (error) std::rethrow_exception(error);
+
+	auto& output = my_shapes::output();
+	for (const auto& chunk : outputs) output << chunk;
+}
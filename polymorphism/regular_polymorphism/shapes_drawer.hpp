@@ -1,5 +1,14 @@
 #pragma once
 #include "shapes_interface.hpp"
+#include "thread_pool.hpp"
+#include <cstddef>
 #include <vector>
 
-void draw_shapes(const std::vector<my_shapes::shape>& shapes);
\ No newline at end of file
+void draw_shapes(const std::vector<my_shapes::shape>& shapes);
+
+// Draws chunks of chunk_size shapes on executor and on the calling thread.
+// Each chunk draws to its own buffer, and the buffers are written to
+// my_shapes::output() in order, so the output is the same as draw_shapes(shapes),
+// except for shapes that write to std::cout directly, which are not ordered.
+void draw_shapes(const std::vector<my_shapes::shape>& shapes, thread_pool& executor,
+	std::size_t chunk_size = 256);
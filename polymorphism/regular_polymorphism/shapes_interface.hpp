@@ -1,8 +1,25 @@
 #pragma once
+#include <cstddef>
 #include <memory>
 #include <iostream>
+#include <new>
+#include <type_traits>
+#include <utility>
 namespace my_shapes {
 
+	// Where shapes draw to. The parallel draw_shapes points it at a buffer for
+	// each chunk of shapes, and writes the buffers out in order. Shapes that
+	// should not depend on it can take the stream as a second parameter of
+	// draw_implementation instead. Shapes that write to std::cout themselves,
+	// such as other_library::triangle, bypass the buffers, so the parallel
+	// draw_shapes does not keep their output in order.
+	inline std::ostream*& current_output() {
+		thread_local std::ostream* output = &std::cout;
+		return output;
+	}
+
+	inline std::ostream& output() { return *current_output(); }
+
 	struct empty_shape {};
 
 	template <typename T>
@@ -10,22 +27,45 @@ namespace my_shapes {
 		t.draw();
 	}
 
-	inline void draw_implementation(empty_shape) { std::cout << "empty\n"; }
+	inline void draw_implementation(empty_shape) { output() << "empty\n"; }
+
+	template <typename T, typename = void>
+	struct draws_to_stream : std::false_type {};
+
+	template <typename T>
+	struct draws_to_stream<T, std::void_t<decltype(draw_implementation(
+		std::declval<const T&>(), std::declval<std::ostream&>()))>> : std::true_type {};
+
+	// Draws t, passing output() to draw_implementation if it takes a stream.
+	template <typename T>
+	void draw_to_output(const T& t) {
+		if constexpr (draws_to_stream<T>::value)
+			draw_implementation(t, output());
+		else
+			draw_implementation(t);
+	}
 
 	class shape {
 	public:
 		shape() = default;
-		template <typename T>
+		template <typename T, typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, shape>>>
 		explicit shape(T&& t)
-			: ptr_(std::make_unique<shape_implementation<T>>(std::forward<T>(t))) {}
-		shape(shape&&) = default;
-		shape(const shape& other) : ptr_(other.ptr_->clone()) {}
-		shape& operator=(shape&&) = default;
+			: ptr_(create<std::decay_t<T>>(&buffer_, std::forward<T>(t))) {}
+		shape(shape&& other) noexcept : ptr_(other.release_to(&buffer_)) {}
+		shape(const shape& other) : ptr_(other.ptr_ ? other.ptr_->clone_(&buffer_) : nullptr) {}
+		shape& operator=(shape&& other) noexcept {
+			if (this != &other) {
+				reset();
+				ptr_ = other.release_to(&buffer_);
+			}
+			return *this;
+		}
 		shape& operator=(const shape& other) {
 			auto new_shape = other;
 			(*this) = std::move(new_shape);
 			return *this;
 		}
+		~shape() { reset(); }
 
 		void draw()const {
 			if (ptr_)
@@ -35,29 +75,78 @@ namespace my_shapes {
 		}
 
 	private:
+		// Small shapes are stored in buffer_ instead of on the heap.
+		using buffer = std::aligned_storage_t<4 * sizeof(void*), alignof(std::max_align_t)>;
+
 		struct shape_interface {
 			virtual void draw_() const = 0;
-			virtual std::unique_ptr<shape_interface> clone() const = 0;
+			// Copies to buffer if the shape fits, and to the heap otherwise.
+			virtual shape_interface* clone_(buffer* b) const = 0;
+			// Moves a shape stored inline to buffer. Shapes on the heap stay put.
+			virtual shape_interface* move_(buffer* b) noexcept = 0;
+			virtual void destroy_() noexcept = 0;
+		protected:
 			~shape_interface() = default;
 		};
 
 		template <typename T>
-		struct shape_implementation : shape_interface {
+		struct shape_implementation;
+
+		template <typename T>
+		static constexpr bool fits_inline() {
+			return sizeof(shape_implementation<T>) <= sizeof(buffer) &&
+				alignof(shape_implementation<T>) <= alignof(buffer) &&
+				std::is_nothrow_move_constructible_v<T>;
+		}
+
+		template <typename T, typename U>
+		static shape_interface* create(buffer* b, U&& u) {
+			if constexpr (fits_inline<T>())
+				return ::new (static_cast<void*>(b)) shape_implementation<T>(std::forward<U>(u));
+			else
+				return new shape_implementation<T>(std::forward<U>(u));
+		}
+
+		template <typename T>
+		struct shape_implementation final : shape_interface {
 			void draw_() const override {
-				draw_implementation(t_);
+				draw_to_output(t_);
 			}
-			std::unique_ptr<shape_interface> clone() const override {
-				return std::make_unique<shape_implementation>(t_);
+			shape_interface* clone_(buffer* b) const override {
+				return create<T>(b, t_);
+			}
+			shape_interface* move_(buffer* b) noexcept override {
+				if constexpr (fits_inline<T>()) {
+					auto moved = ::new (static_cast<void*>(b)) shape_implementation(std::move(t_));
+					this->~shape_implementation();
+					return moved;
+				}
+				else {
+					return this;
+				}
+			}
+			void destroy_() noexcept override {
+				if constexpr (fits_inline<T>())
+					this->~shape_implementation();
+				else
+					delete this;
 			}
-			shape_implementation() = default;
 			template <typename U>
 			explicit shape_implementation(U&& u) : t_(std::forward<U>(u)) {}
 
 			T t_;
 		};
 
-		std::unique_ptr<shape_interface> ptr_;
+		shape_interface* release_to(buffer* b) noexcept {
+			return ptr_ ? std::exchange(ptr_, nullptr)->move_(b) : nullptr;
+		}
+
+		void reset() noexcept {
+			if (ptr_) std::exchange(ptr_, nullptr)->destroy_();
+		}
+
+		shape_interface* ptr_ = nullptr;
+		buffer buffer_;
 	};
 
 }  // namespace shapes
-
@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Runs tasks on a fixed set of threads, in the order they were submitted.
+class thread_pool {
+public:
+	explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency()) {
+		for (std::size_t i = 0; i < threads; ++i) threads_.emplace_back([this] { run(); });
+	}
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+	~thread_pool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			done_ = true;
+		}
+		ready_.notify_all();
+		for (auto& t : threads_) t.join();
+	}
+
+	void execute(std::function<void()> task) {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			tasks_.push_back(std::move(task));
+		}
+		ready_.notify_one();
+	}
+
+	std::size_t size() const { return threads_.size(); }
+
+private:
+	void run() {
+		for (;;) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				ready_.wait(lock, [this] { return done_ || !tasks_.empty(); });
+				if (tasks_.empty()) return;
+				task = std::move(tasks_.front());
+				tasks_.pop_front();
+			}
+			task();
+		}
+	}
+
+	std::mutex mutex_;
+	std::condition_variable ready_;
+	std::deque<std::function<void()>> tasks_;
+	bool done_ = false;
+	std::vector<std::thread> threads_;
+};